@@ -0,0 +1,46 @@
+/* File arena.h: Phase-scoped bump-pointer allocation for DJ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* An arena hands out memory by bumping a pointer through large blocks.
+   Individual allocations are never freed; instead the whole arena is
+   released in one shot when the compiler phase that owns it is done. */
+typedef struct arenablock {
+  struct arenablock *next;
+  size_t size;  /* usable bytes after this header */
+} ArenaBlock;
+
+typedef struct {
+  const char *name;      /* for statistics */
+  ArenaBlock *blocks;    /* most recent block first */
+  char *next;            /* next free byte in the current block */
+  size_t left;           /* free bytes left in the current block */
+  unsigned long numAllocs;  /* allocations since the last release, */
+  size_t bytesAllocated;    /* and bytes handed out (compactAST() in
+                               ast.h carries both over to its copy) */
+  size_t bytesReserved;     /* bytes obtained from malloc and not released */
+  size_t peakReserved;      /* high-water mark of bytesReserved */
+} Arena;
+
+/* The compiler's arenas:
+   astArena holds ASTree and ASTList nodes, symtblArena holds the
+   tables built by setupSymbolTables().  Each thread has its own. */
+extern _Thread_local Arena astArena;
+extern _Thread_local Arena symtblArena;
+
+/* Returns size bytes (suitably aligned for any type) from arena a.
+   The memory is not zeroed.  Exits the compiler if malloc fails. */
+void *arenaAlloc(Arena *a, size_t size);
+
+/* Frees every block of arena a at once; all pointers into it die. */
+void arenaRelease(Arena *a);
+
+/* Print per-arena allocation counts and bytes, and the process's peak
+   resident set size, to out */
+void printMemoryStats(FILE *out);
+
+#endif
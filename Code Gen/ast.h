@@ -1,100 +1,189 @@
-/* File ast.h: Abstract-syntax-tree data structure for DJ */
-
-#ifndef AST_H
-#define AST_H
-
-#include <stdlib.h>
-
-/* define types of AST nodes */
-typedef enum {
-  /* program, class, field, and method declarations: */
-  PROGRAM, 
-  CLASS_DECL_LIST, /* class declarations */
-  FINAL_CLASS_DECL,
-  NONFINAL_CLASS_DECL,
-  VAR_DECL_LIST, /* variable declarations */
-  VAR_DECL,   
-  METHOD_DECL_LIST, /* method declarations */
-  FINAL_METHOD_DECL,
-  NONFINAL_METHOD_DECL, 
-  /* types, including generic IDs: */
-  NAT_TYPE, 
-  AST_ID, 
-  /* expression-lists: */
-  EXPR_LIST,
-  /* expressions: */
-  DOT_METHOD_CALL_EXPR, /* E.ID(E) */
-  METHOD_CALL_EXPR,     /* ID(E) */
-  DOT_ID_EXPR,          /* E.ID */
-  ID_EXPR,              /* ID */
-  DOT_ASSIGN_EXPR,      /* E.ID = E */
-  ASSIGN_EXPR,          /* ID = E */
-  PLUS_EXPR,            /* E + E */
-  MINUS_EXPR,           /* E - E */
-  TIMES_EXPR,           /* E * E */
-  EQUALITY_EXPR,        /* E==E */
-  LESS_THAN_EXPR,       /* E < E */
-  NOT_EXPR,             /* !E */
-  OR_EXPR,              /* E||E */
-  ASSERT_EXPR,          /* assert E */
-  IF_THEN_ELSE_EXPR,    /* if(E) {Es} else {Es} */
-  WHILE_EXPR,           /* while(E) {Es} */
-  PRINT_EXPR,           /* printNat(E) */
-  READ_EXPR,            /* readNat() */
-  THIS_EXPR,            /* this */
-  NEW_EXPR,             /* new */
-  NULL_EXPR,            /* null */
-  NAT_LITERAL_EXPR,     /* N */
-} ASTNodeType;
-
-/* define a list of AST nodes */
-typedef struct astlistnode {
-  struct astnode *data;
-  struct astlistnode *next;
-} ASTList;
-
-/* define the actual AST nodes */
-typedef struct astnode {
-  ASTNodeType typ;
-  /* list of children nodes: */
-  ASTList *children; /* head of the list of children */
-  ASTList *childrenTail;
-  /* which source-program line does this node end on: */
-  unsigned int lineNumber;
-  /* node attributes: */
-  unsigned int natVal;
-  char *idVal;
-  /* Node attributes used on the first 6 kinds of expressions enumerated above
-    (E.ID(E), ID(E), E.ID, ID, E.ID = E, and ID = E).
-    These attributes get set during type checking and used during code gen,
-    so code gen doesn't duplicate the work of the type checker. 
-    The attributes store the statically determined class and member number
-    of an ID that refers to a method or variable.  
-    When these attributes are all 0, the ID refers not to a member of a class
-    but instead to a local/parameter variable. */
-  unsigned int staticClassNum; /* class number in which this member resides */
-  unsigned int staticMemberNum; /* when set to i, this member is the ith 
-                                   method/var in the staticClassNum-th class */
-} ASTree;
-
-
-/* METHODS TO CREATE AND MANIPULATE THE AST */
-/* Create a new AST node of type t having only one child.
-   (That is, create a one-node list of children for the new tree.)
-   If the child argument is NULL, then the single list node in the 
-   new AST node's list of children will have a NULL data field.
-   If t is NAT_LITERAL_EXPR then the proper natAttribute should be
-   given; otherwise natAttribute is ignored.
-   If t is AST_ID then the proper idAttribute should be given;
-   otherwise idAttribute is ignored.
-*/
-ASTree *newAST(ASTNodeType t, ASTree *child, unsigned int natAttribute, 
-  char *idAttribute, unsigned int lineNum);
-
-/* Append an AST node onto a parent's list of children */
-void appendToChildrenList(ASTree *parent, ASTree *newChild);
-
-/* Print the AST to stdout with indentations marking tree depth. */
-void printAST(ASTree *t);
-
-#endif
+/* File ast.h: Abstract-syntax-tree data structure for DJ */
+
+#ifndef AST_H
+#define AST_H
+
+#include <stdlib.h>
+#include "sha256.h"
+
+/* define types of AST nodes */
+typedef enum {
+  /* program, class, field, and method declarations: */
+  PROGRAM, 
+  CLASS_DECL_LIST, /* class declarations */
+  FINAL_CLASS_DECL,
+  NONFINAL_CLASS_DECL,
+  VAR_DECL_LIST, /* variable declarations */
+  VAR_DECL,   
+  METHOD_DECL_LIST, /* method declarations */
+  FINAL_METHOD_DECL,
+  NONFINAL_METHOD_DECL, 
+  /* types, including generic IDs: */
+  NAT_TYPE, 
+  AST_ID, 
+  /* expression-lists: */
+  EXPR_LIST,
+  /* expressions: */
+  DOT_METHOD_CALL_EXPR, /* E.ID(E) */
+  METHOD_CALL_EXPR,     /* ID(E) */
+  DOT_ID_EXPR,          /* E.ID */
+  ID_EXPR,              /* ID */
+  DOT_ASSIGN_EXPR,      /* E.ID = E */
+  ASSIGN_EXPR,          /* ID = E */
+  PLUS_EXPR,            /* E + E */
+  MINUS_EXPR,           /* E - E */
+  TIMES_EXPR,           /* E * E */
+  EQUALITY_EXPR,        /* E==E */
+  LESS_THAN_EXPR,       /* E < E */
+  NOT_EXPR,             /* !E */
+  OR_EXPR,              /* E||E */
+  ASSERT_EXPR,          /* assert E */
+  IF_THEN_ELSE_EXPR,    /* if(E) {Es} else {Es} */
+  WHILE_EXPR,           /* while(E) {Es} */
+  PRINT_EXPR,           /* printNat(E) */
+  READ_EXPR,            /* readNat() */
+  THIS_EXPR,            /* this */
+  NEW_EXPR,             /* new */
+  NULL_EXPR,            /* null */
+  NAT_LITERAL_EXPR,     /* N */
+} ASTNodeType;
+
+/* what a name used as a variable denotes (see ASTree below) */
+typedef enum {
+  VAR_UNRESOLVED, /* not (yet) resolved, or undeclared */
+  VAR_LOCAL,      /* a local of the enclosing method or main block */
+  VAR_PARAM,      /* the enclosing method's parameter */
+  VAR_FIELD,      /* a field of this object, possibly inherited */
+} VarKind;
+
+/* define a list of AST nodes */
+typedef struct astlistnode {
+  struct astnode *data;
+  struct astlistnode *next;
+} ASTList;
+
+/* define the actual AST nodes
+   The fields the typechecker and code generator read on every visit
+   are packed together at the front of the node (64 bytes in all). */
+typedef struct astnode {
+  ASTNodeType typ;
+  /* which source-program line does this node end on: */
+  unsigned int lineNumber;
+  /* node attributes: */
+  unsigned int natVal;
+  int idNum;   /* interned number of idVal (see intern.h), or -1 */
+  /* Node attributes used on the first 6 kinds of expressions enumerated above
+    (E.ID(E), ID(E), E.ID, ID, E.ID = E, and ID = E).
+    These attributes get set during type checking and used during code gen,
+    so code gen doesn't duplicate the work of the type checker. 
+    The attributes store the statically determined class and member number
+    of an ID that refers to a method or variable.  
+    When staticClassNum is 0, the ID refers not to a member of a class
+    but instead to a local/parameter variable, and staticMemberNum is the
+    local's index in its method's (or the main block's) locals.
+    (A NEW_EXPR node's staticClassNum is the class being instantiated.) */
+  unsigned int staticClassNum; /* class number in which this member resides */
+  unsigned int staticMemberNum; /* when set to i, this member is the ith 
+                                   method/var in the staticClassNum-th class */
+  /* The static type typeExpr() gave this expression: a class number,
+     -1 for nat or -2 for null; -3 on nodes not (yet) typechecked. */
+  int staticType;
+  /* Set by resolveNames() (see symtbl.h), before type checking, on ID and
+     ID = E nodes and on the AST_ID naming their variable: what the name
+     denotes, and where the variable lives--its offset from the frame
+     pointer for a local or parameter, or within this object for a field.
+     resolveNames() sets the statics above for these nodes too. */
+  VarKind varKind;
+  int varOffset;
+  /* list of children nodes: */
+  ASTList *children; /* head of the list of children */
+  ASTList *childrenTail;
+  char *idVal; /* shared text of the interned name; never freed per node */
+} ASTree;
+
+
+/* METHODS TO CREATE AND MANIPULATE THE AST */
+/* Create a new AST node of type t having only one child.
+   (That is, create a one-node list of children for the new tree.)
+   If the child argument is NULL, then the single list node in the 
+   new AST node's list of children will have a NULL data field.
+   If t is NAT_LITERAL_EXPR then the proper natAttribute should be
+   given; otherwise natAttribute is ignored.
+   If t is AST_ID then the proper idAttribute should be given;
+   otherwise idAttribute is ignored.  The name is interned, so every
+   AST_ID with the same name shares one copy of its text and idNum.
+*/
+ASTree *newAST(ASTNodeType t, ASTree *child, unsigned int natAttribute, 
+  char *idAttribute, unsigned int lineNum);
+
+/* Append an AST node onto a parent's list of children */
+void appendToChildrenList(ASTree *parent, ASTree *newChild);
+
+/* Copy the whole tree rooted at t into a fresh run of astArena, nodes in
+   preorder, with every node's list of children stored as a contiguous
+   array of ASTList cells (so t->children[i] is the ith child cell and
+   following next pointers walks straight through memory).  The original
+   nodes are released; returns the copy of t.  Run this after parsing and
+   before setupSymbolTables(), which keeps pointers into the tree. */
+ASTree *compactAST(ASTree *t);
+
+/* Print the AST to stdout with indentations marking tree depth. */
+void printAST(ASTree *t);
+
+/* Print node t's type and attribute, as printAST() does (no newline) */
+void printNodeTypeAndAttribute(ASTree *t);
+
+/* Scan the DJ program in file filename without parsing it and return
+   its number of tokens (not counting the end of file), then reset the
+   scanner.  If useMmap is nonzero the scanner reads a memory mapping of
+   the whole file; otherwise it reads the file through yyin.  For timing
+   the scanner on its own; defined with the parser, in dj.y. */
+int lexFile(char *filename, int useMmap);
+
+/* BINARY AST FILES (.djast)
+   A .djast file holds a whole AST, so a later stage can start from it
+   without lexing and parsing the program again.  After a header (magic
+   number, format version and counts) it holds the text of every name
+   the tree uses, then one fixed-size record per child cell in preorder
+   carrying the node's attributes, including the staticClassNum,
+   staticMemberNum and staticType annotations set during type checking.
+   Files use the byte order of the machine that wrote them. */
+
+/* Write the tree rooted at t to file filename.
+   Returns 0 on success; otherwise prints an error and returns nonzero. */
+int writeASTFile(ASTree *t, char *filename);
+
+/* Map the .djast file filename into memory and rebuild its tree in
+   astArena, laid out as compactAST() lays trees out; the names are
+   interned into this thread's table.  An unreadable, malformed, or
+   wrong-version file calls compileFailed() (see recover.h). */
+ASTree *loadASTFile(char *filename);
+
+/* Returns nonzero if filename names a .djast file rather than DJ source */
+int isASTFileName(char *filename);
+
+/* THE PARSER'S ENTRY POINT (defined in dj.y) */
+/* Parse the DJ program in file filename and return its AST, already
+   compacted by compactAST().  If useMmap is nonzero the file is scanned
+   through a memory mapping; if lexThreads > 0 (hand-written scanner
+   only) it is lexed on that many threads before parsing.  The scanner
+   is reset afterwards, so a thread may parse many files in turn.
+   Lex and syntax errors call compileFailed() (see recover.h). */
+ASTree *parseFile(char *filename, int useMmap, int lexThreads);
+
+/* Have the parser feed every token it reads from now on into digest
+   (or stop, if digest is NULL): each token's code, plus the text of
+   names and numbers.  Whitespace, comments and line breaks never reach
+   the digest, so it fingerprints the program's normalized token
+   stream.  Each thread has its own setting. */
+void digestTokens(Sha256 *digest);
+
+/* Reset the scanner and release its input (defined by the scanner).
+   parseFile() does this itself, unless an error cut the parse short. */
+void finishSource(void);
+
+/* Free every AST node at once (they all live in astArena, see arena.h).
+   Call only when no later phase needs the tree. */
+void releaseAST();
+
+#endif
@@ -1,605 +1,872 @@
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <stdarg.h>
-#include "codegen.h"
-#include "symtbl.h"
-
-#define MAX_DISM_ADDR 65535
-
-// global for the DISM output file
-FILE *fout;
-// Global to remember the next unique label number to use
-unsigned int labelNumber = 0;
-int needVtable = 0; // flag to indicate if we need a vtable
-
-// declare mutually recursive functions (defs and docs appera below)
-void codeGenExpr (ASTree *t, int ClassNumber, int MethodNumber);
-void codeGenExprs(ASTree *expList, int ClassNumber, int MethodNumber);
-// print message and exit under an exceptional condition
-void internalCGerror(char *msg) {
-    fprintf(stderr, "Internal Code Generator Error: %s\n", msg);
-    exit(1);
-}
-
-
-void addCode(char *code, ...) {
-    va_list args;
-    va_start(args, code);
-    
-    // Check if the first character is '#'
-    if (code[0] != '#') {
-        fprintf(fout, "     "); // 7 spaces for label
-    }
-    
-    vfprintf(fout, code, args);
-    va_end(args);
-}
-
-
-// using the global classesST, calculate the total number of fields,
-// including inherited fields, in an object of the given type
-int getNumObjectFields(int type) {
-    int value = classesST[type].numVars;
-    if (classesST[type].superclass <=0 ) return value;
-    value += getNumObjectFields(classesST[type].superclass);
-    return value; 
-}
-
-// generate code that increments the stack pointer
-void incSP() {
-    addCode("mov 1 1\n");
-    addCode("add 6 6 1; #SP++\n");
-}
-// generate code that decrements the stack pointer
-void decSP() {
-    addCode("mov 1 1\n");
-    addCode("sub 6 6 1; #SP--\n");
-    addCode("blt 5 6 #labelNum%d ; branch if HP<SP\n", labelNumber);
-    addCode("mov 1 77 ; error code 77 no stack memory\n");
-    addCode("hlt 1; out of stack memory!!\n");
-    addCode("#labelNum%d: mov 0 0\n", labelNumber);
-    labelNumber++;
-}
-
-// output code to check for a null value at the top of the stack
-// if the top stack value ast M(SP+1)) is null (0), the DISM code output will halt
-void checkNullDereference() {
-    addCode("add 1 6 1; 1 = SP + 1\n");
-    addCode("lod 1 1 0; 1 = M(SP+1)\n");
-    // check if loaded value is 0
-    addCode("beq 1 0 #halt%d\n", labelNumber);
-    addCode("jmp 0 #labelNum%d\n", labelNumber);
-    addCode("#halt%d: mov 0 0\n", labelNumber);
-    addCode("mov 1 77\n");
-    addCode("hlt 1; Null pointer dereference\n");
-    addCode("#labelNum%d: mov 0 0\n", labelNumber);
-    labelNumber++;
-}
-
-/* generate DISM code for the given single expression, which appears in the given class and method (or maing block).
-if classNumber <0 then methodNumber may be anything and we assume
-we are generating code for the main block*/
-void codeGenExpr(ASTree *t, int ClassNumber, int MethodNumber) {
-    int trueLabel, falseLabel, endLabel, returnLabel, nextLabel, elseLabel, failLabel, passLabel, whileLabel;
-    if (!t) return;
-    switch (t->typ) {
-    case NAT_TYPE:
-         addCode("mov 1 %d\n", t->natVal);
-         addCode("str 6 0 1\n");
-         decSP();
-         break;
-    case AST_ID:
-         if (ClassNumber <0 ) {
-             for (int i = 0; i < numMainBlockLocals; i++) {
-                 if (strcmp(mainBlockST[i].varName, t->idVal) == 0) {
-                     addCode("mov 1 %d\n", i);
-                     addCode("str 6 0 1\n");
-                     //printf("hello!\n");
-                     decSP();
-                     break;
-                 }
-             }
-         }
-         else {
-             for (int i = 0; i < classesST[ClassNumber].methodList[MethodNumber].numLocals; i++) {
-                 if (strcmp(classesST[ClassNumber].methodList[MethodNumber].localST[i].varName, t->idVal) == 0) {
-                     addCode("mov 1 %d\n", i);
-                     addCode("str 6 0 1\n");
-                     decSP();
-                     break;
-                 }
-             }
-         }
-         break;
-
-    //level 3
-    case DOT_METHOD_CALL_EXPR:
-    returnLabel = labelNumber++;
-
-    // Push the return label onto the stack
-    addCode("str 6 0 %d; push retLabel on stack\n", returnLabel);
-    decSP();
-
-    // pushes this on stack
-    codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-    checkNullDereference();
-
-    // Push the static class number onto the stack
-    addCode("mov 1 %d\n", t->staticClassNum);
-    addCode("str 6 0 1; push class number on stack\n");
-    decSP();
-
-    // Push the static method number onto the stack
-    addCode("mov 1 %d\n", t->staticMemberNum);
-    addCode("str 6 0 1; push method number on stack\n");
-    decSP();
-
-    // Evaluate the method arguments
-    codeGenExprs(t->children->next->data, ClassNumber, MethodNumber);
-
-    // Jump to the virtual table to resolve the method call
-    addCode("jmp 0 #VTABLE\n");
-
-    // Return label for after the method call
-    addCode("#%d: mov 0 0\n", returnLabel);
-    break;
-    
-    case METHOD_CALL_EXPR:
-        returnLabel = labelNumber++;
-        needVtable = 1;
-        addCode("str 6 0 %d; push retLabel on stack\n", returnLabel);
-        decSP();
-        
-        // pushes caller # on stack
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        checkNullDereference();
-
-        addCode("mov 1 %d\n",t->staticClassNum);
-        addCode("str 6 0 1; push class number on stack\n");
-        decSP();
-        addCode("mov 1 %d\n",t->staticMemberNum);
-        addCode("str 6 0 1; push method number on stack\n");
-        decSP();
-         // leave on stack
-        codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-        addCode("jmp 0 #VTABLE\n");
-        addCode("#%d: mov 0 0\n", returnLabel);
-        break;
-    
-    case DOT_ID_EXPR:
-    
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        checkNullDereference();
-        incSP();
-        addCode("lod 1 6 0; load mem of r1\n");
-        addCode("add 1 1 %d; r1 = offset + base address \n", t->staticMemberNum);
-        addCode("lod 1 1 0; load mem at [A]\n");
-        addCode("str 6 0 1; push r1 on stack\n");
-        decSP();
-        break;
-    
-    case ID_EXPR: 
-        if(t->staticClassNum == 0){
-            addCode("sub 1 7 %d; r1 = FP - %d\n", t->staticMemberNum);
-            addCode("lod 1 1 0; r1 = M(r1)\n");
-
-            addCode("str 6 0 1; push r1 on stack\n");
-            decSP();
-            //codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-            // may need to do this instead?
-        }
-        else{
-            addCode("sub 1 7 1; r1 = (this)\n");
-            addCode("lod 1 1 0; load 'this' address\n");
-            // does this need a null dereference check?
-            addCode("add 1 1 %d; r1 = offset + base address \n", t->staticMemberNum);
-            addCode("lod 1 1 0; load mem at [A]\n");
-            addCode("str 6 0 1; push r1 on stack\n");
-            decSP();
-        }
-        break;
-    
-    case DOT_ASSIGN_EXPR:
-        codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        checkNullDereference();
-
-        addCode("lod 1 6 1; load base address of E1\n");
-        addCode("add 1 1 %d; r1 = offset + base address \n", t->staticMemberNum);
-        addCode("str 6 1 1; store A on stack\n");
-
-        addCode("lod 1 6 1; load address of A\n");
-        addCode("lod 2 6 2; load value of r\n");
-        addCode("str 2 1 0; store r at [A]\n");
-        // make sure we leave r on the stack only
-        incSP();
-        break;
-
-
-    case ASSIGN_EXPR:
-        if(t->staticClassNum == 0){
-            addCode("sub 1 7 %d; r1 = FP - offset\n", t->staticMemberNum);
-            addCode("lod 1 1 0; r1 = M(r1)\n");
-            addCode("str 6 0 1; push r1 on stack\n");
-            decSP();
-        }
-        else{
-            addCode("sub 1 7 1; r1 = (this)\n");
-            addCode("lod 1 1 0; load 'this' address\n");
-            addCode("add 1 1 %d; r1 = offset + base address \n", t->staticMemberNum);
-            addCode("lod 1 1 0; load mem at [A]\n");
-            addCode("str 6 0 1; push r1 on stack\n");
-            decSP();
-        }
-        // we can leave this value on stack
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        addCode("lod 1 6 1; load value r\n");
-        addCode("lod 2 6 2; get address A\n");
-        addCode("str 2 1 0; store r at [A]\n");
-        break;
-
-    case PLUS_EXPR:
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("lod 2 6 1; load mem of r2\n");
-         addCode("add 1 1 2; r1 = r1 + r2\n");
-         addCode("str 6 2 1; store result at +2\n");
-         incSP();
-         break;
-         
-    case MINUS_EXPR:
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("lod 2 6 1; load mem of r2\n");
-         addCode("sub 1 1 2; r1 = r1 - r2\n");
-         addCode("str 6 2 1; store result at +2\n");
-         incSP();
-         break;
-
-    case TIMES_EXPR:
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("lod 2 6 1; load mem of r2\n");
-         addCode("mul 1 1 2; r1 = r1 * r2\n");
-         addCode("str 6 2 1; store result at +2\n");
-         incSP();
-         break;
-
-    case EQUALITY_EXPR:
-         trueLabel = labelNumber++;
-         endLabel = labelNumber++;
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("lod 2 6 1; load mem of r2\n");
-         addCode("beq 1 2 #true%d\n", trueLabel);
-         addCode("mov 1 0\n");
-         addCode("jmp 0 #end%d\n", endLabel);
-         addCode("#true%d: mov 0 0\n", trueLabel);
-         addCode("mov 1 1 ; condition true\n");
-         addCode("#end%d: mov 0 0\n", endLabel);
-         addCode("str 6 2 1 ; return final result on stack\n");
-         incSP();
-         break;
-
-    case LESS_THAN_EXPR:
-         trueLabel = labelNumber++;
-         endLabel = labelNumber++;
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("lod 2 6 1; load mem of r2\n");
-         addCode("blt 1 2 #true%d\n", trueLabel);
-         addCode("mov 1 0\n");
-         addCode("jmp 0 #end%d\n", endLabel);
-         addCode("#true%d: mov 0 0 ;\n", trueLabel);
-         addCode("mov 1 1 ; condition true\n");
-         addCode("#end%d: mov 0 0\n", endLabel);
-         addCode("str 6 2 1 ; return final result on stack\n");
-         incSP();
-         break;
-
-    case NOT_EXPR:
-        trueLabel = labelNumber++;
-        endLabel = labelNumber++;
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        addCode("lod 1 6 1; load mem of r1\n");
-        addCode("beq 0 1 #true%d ; not is true\n", trueLabel);
-        addCode("mov 1 0\n");
-        addCode("jmp 0 #end%d ; not is false\n", endLabel);
-        addCode("#true%d: mov 0 0 ; not is false\n", trueLabel);
-        addCode("mov 1 1 ; not is true\n");
-        addCode("#end%d: mov 0 0\n", endLabel);
-        addCode("str 6 1 1 ; return final result on stack\n");
-        break;
-
-    case OR_EXPR:
-         nextLabel = labelNumber++;
-         trueLabel = labelNumber++;
-         falseLabel = labelNumber++;
-         endLabel = labelNumber++;
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 2; load mem of r1\n");
-         addCode("beq 0 1 #next%d\n", nextLabel);
-         addCode("jmp 0 #true%d\n", trueLabel);
-         addCode("#next%d: mov 0 0 ; condition true\n", nextLabel);
-         addCode("lod 1 6 1; load mem of r2\n");
-         addCode("beq 0 1 #false%d\n", falseLabel);
-         addCode("#true%d: mov 0 0\n", trueLabel);
-         addCode("mov 1 1 ; condition true\n");
-         addCode("jmp 0 #end%d ; jump to end\n", endLabel);
-         addCode("#false%d: mov 0 0\n", falseLabel);
-         addCode("mov 1 0 ; condition false\n");
-         addCode("#end%d: mov 0 0\n", endLabel);
-         addCode("str 6 2 1 ; return final result on stack\n");
-         incSP();
-         break;
-        
-
-    case ASSERT_EXPR:
-         failLabel = labelNumber++;
-         passLabel = labelNumber++;
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         // we can just leave this value on stack
-         addCode("lod 1 6 1; load mem of r1\n");
-         addCode("beq 0 1 #fail%d\n", failLabel);
-         addCode("jmp 0 #pass%d\n", passLabel);
-         addCode("#fail%d: mov 0 0\n", failLabel);
-         addCode("halt 0 ; assertion failed\n");
-         
-         addCode("#pass%d: mov 0 0 ; assertion passed\n", passLabel);
-         break;
-
-    case IF_THEN_ELSE_EXPR:
-         elseLabel = labelNumber++;
-         endLabel = labelNumber++;
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         addCode("lod 1 6 1; load mem of sp+1\n");
-         addCode("beq 0 1 #else%d\n", elseLabel);
-         incSP();
-         codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-         addCode("jmp 0 #end%d\n", endLabel);
-         incSP();
-         addCode("#else%d: mov 0 0\n", elseLabel);
-         codeGenExpr(t->children->next->next->data, ClassNumber, MethodNumber);
-         addCode("#end%d: mov 0 0\n", endLabel);
-         break;
-
-    case WHILE_EXPR:
-        whileLabel = labelNumber++;
-        endLabel = labelNumber++;
-        addCode("#while%d: mov 0 0\n", whileLabel);
-        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-        incSP();
-        addCode("lod 1 6 0; load mem of r1\n");
-        addCode("beq 0 1 #end%d; condition not true\n", endLabel);
-        codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
-        addCode("jmp 0 #while%d ; jump to start of while\n", whileLabel);
-        addCode("#end%d: mov 0 0\n", endLabel);
-        addCode("str 6 1 0 ; end loop and store 0 on top of stack\n");
-        break;
-
-    case PRINT_EXPR:
-         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
-         // we can just leave this value on stack
-         addCode("lod 1 6 1; load mem of r1 for printing\n");
-         addCode("ptn 1\n");
-         break;
-    case READ_EXPR:
-         addCode("rdn 1;  load input to r1\n");
-         addCode("str 6 0 1; store input at sp\n");
-         decSP();
-         break;
-    case THIS_EXPR:
-         // load this from FP-1
-         addCode("sub 1 7 1; r1 = FP - 1\n");
-         addCode("lod 1 1 0; r1 = M(r1)\n");
-
-         addCode("str 6 0 1; push this on stack\n");
-         decSP();
-         break;
-    // level 3
-    case NEW_EXPR:
-         int numFields = 0;
-         int currentClass = t->staticClassNum;
-         while (currentClass > 0) {
-             numFields += getNumObjectFields(currentClass);
-             currentClass = classesST[currentClass].superclass;
-         }
-         //check HP < max_dism address
-        addCode("add 1 5 1; r1 = HP + 1\n");
-        addCode("add 1 1 %d; r1 = HP + %d\n +1", numFields, numFields);
-        addCode("mov 2 65535; r2 = 65535\n");
-        addCode("blt 1 2 #goodHP%d\n", labelNumber);
-        addCode("mov 1 77 ;\n");
-        addCode("hlt 1; out of heap memory!!\n");
-        addCode("#goodHP%d: mov 0 0\n", labelNumber);
-        labelNumber++;
-
-         addCode("mov 1 1\n");
-         for (int i = 0; i < numFields; i++) {
-             addCode("str 5 0 0; allocate a field\n");
-             addCode("add 5 5 1; HP++\n");
-         }
-         addCode("mov 2 %d; R2 = new object type\n", t->staticClassNum);
-         addCode("str 5 0 2;");
-         addCode("str 6 0 5; push new-obj address\n");
-         addCode("add 5 5 1; HP++\n");
-         decSP();
-         break;
-    case NULL_EXPR:
-         addCode("str 6 0 0; push null on stack\n");
-         decSP();
-         break;
-
-    case NAT_LITERAL_EXPR:
-    if (t->typ == NAT_LITERAL_EXPR) {
-        addCode("mov 1 %d\n", t->natVal);
-        addCode("str 6 0 1; M[SP] <-R1 (a nat literal)\n");
-        decSP();
-        break;
-    }
-    
-    }
-
-}
-/* GENERATE dism CODE FOR AN EXPRESSION LIST, WHICH APPEARS IN
-THE GIVEN CLASS AND METHOD or main block
-If classNumber <0 then methodNumber may be anything and we assume 
-we are generating code for the programs main block*/
-void codeGenExprs(ASTree *expList, int ClassNumber, int MethodNumber) {
-    ASTList *childIterator = expList->children;
-    while (childIterator != NULL) {
-        codeGenExpr(childIterator->data, ClassNumber, MethodNumber);
-        childIterator = childIterator->next;
-        if (childIterator != NULL) {
-            incSP();
-        }
-    }
-}
-
-/* generate DISM code as the prologue to the given method or main block. If classNumber < 0
-then methodNumber may be anything and we assume we are generating code for the progtrams main block*/
-void genPrologue(int ClassNumber, int MethodNumber) {
-    // For the main block
-    if (ClassNumber < 0) {
-        addCode("mov 7 65535   ; initialize FP\n");
-        addCode("mov 6 65535   ; initialize SP\n");
-        addCode("mov 5 1       ; initialize HP\n");
-
-        // Allocate stack space for main block locals
-        for (int i = 0; i < numMainBlockLocals; i++) {
-            addCode("str 6 0 0  ; Allocate stack space for main local %d\n", i);
-            decSP();
-        }
-
-        addCode("mov 0 0       ; BEGIN METHOD/MAIN-BLOCK BODY\n");
-    }
-    // For a method in a class
-    else {
-        // Allocate stack space for method locals
-        for (int i = 0; i < classesST[ClassNumber].methodList[MethodNumber].numLocals; i++) {
-            addCode("str 6 0 0  ; Allocate stack space for method local %d\n", i);
-            decSP();
-        }
-
-        // Save the old FP
-        addCode("str 6 0 7   ; Save old FP\n");
-        decSP();
-
-        // Update FP to point to the current SP
-        addCode("add 6 7 0   ; Have SP point to FP\n");
-
-        // Adjust FP to account for the return address
-        addCode("mov 1 2     ; Load offset for return address\n");
-        addCode("sub 7 7 1   ; FP = FP - 2 to point to RA\n");
-    }
-}
-
-/*Generate DISM code as the epiliogue to the given method or main block. If classNumber <0 then methodNumber
-may be anything and we assume we are generating code for the program's main block*/
-void genEpilogue(int ClassNumber, int MethodNumber) {
-    if (ClassNumber < 0) {
-
-        addCode("hlt 0     ; normal program termination\n");
-    }
-    else{
-        addCode("lod 1 7 1  ; load return addr (M(FP-1))\n");
-        addCode("lod 7 7 2  ; Restore caller's FP (M(FP-2))\n");
-        addCode("lod 6 7 3  ; Restore caller's SP (M(FP-3))\n");
-        addCode("jmp 0 1     ; return to caller\n");
-    }
-}
-/* Generate DISM code for the given method or main block. 
-If classNumber < 0 then methodNumber may be anything and we assume we are generating code for the program's main block*/
-void genBody(int ClassNumber, int MethodNumber) {
-    addCode("#CM%d%d: mov 0 0\n", ClassNumber, MethodNumber);
-
-    genPrologue(ClassNumber, MethodNumber);
-    codeGenExprs(classesST[ClassNumber].methodList[MethodNumber].bodyExprs, ClassNumber, MethodNumber);
-    genEpilogue(ClassNumber, MethodNumber);
-}
-/* Map a given (1) static class number, 2 a method number defined in that class,
-and (3) a dynamic object's type to: (a) the dynamic class number and (b)
-the dynamic method number that actually gets called when an object of type (3) dynamically invokes method(2).
-This method assumes that dynamicType is a subtype of staticClass*/
-void getDynamicMethod(int staticClass, int staticMethod, int dynamicType,
-    int *dynamicClassToCall, int *dynamicMethodToCall) {
-        char *targetMethodName = classesST[staticClass].methodList[staticMethod].methodName;
-
-        int currentClass = dynamicType;
-
-        while (currentClass > 0) {
-            for (int i = 0; i < classesST[currentClass].numMethods ; i++) {
-                if (strcmp(classesST[currentClass].methodList[i].methodName, targetMethodName) == 0) {
-                    *dynamicClassToCall = currentClass;
-                    *dynamicMethodToCall = i;
-                    return;
-                }
-            } 
-    }
-}
-
-/*Emit code for the program's vtable, beginning at label #VTABLE.
-The vtable jumps (i.e., dispatches) to code based on
-(1) the dynamic calling object's address (at M(SP+4)),
-(2) the calling object's static type (at M(SP+3)), and
-(3) the static method number (at M(SP+2))*/
-void genVtable() {
-    addCode("#VTABLE:\n");
-    addCode("lod 1 6 4; load object address\n");
-    checkNullDereference();
-    addCode("lod 1 6 4; load object address again after null check\n");
-    addCode("lod 2 6 3; load static type\n");
-    addCode("lod 3 6 2; load static method number\n");
-    int dynClass = 0, dynMethod = 0;
-    //getDynamicMethod(0, 0, 0, &dynClass, &dynMethod);
-    int tableLabel = labelNumber++;
-    for(int dynType = 0; dynType < numClasses; dynType++) {
-        addCode("mov 4 %d; load class number\n", dynType);
-        addCode("beq 1 4 #continueType%d; branch to class\n", dynType);
-        addCode("jmp 0 #skipType%d; branch to next class\n", dynType);
-        addCode("#continueType%d: mov 0 0\n", dynType);
-        for(int staticClass = 0; staticClass < numClasses; staticClass++) {
-            addCode("mov 4 %d; load class number\n", staticClass);
-            addCode("beq 2 4 #continueClass%d%d; branch to class\n", dynType, staticClass);
-            addCode("jmp 0 #skipClass%d%d\n", dynType, staticClass);
-            addCode("#continueClass%d%d: mov 0 0\n", dynType, staticClass);
-            for(int staticMethod = 0; staticMethod < classesST[staticClass].numMethods; staticMethod++) {
-                addCode("mov 4 %d; load method number\n", staticMethod);
-                addCode("beq 3 4 #continueMethod%d%d%d; branch to method\n", dynType, staticClass, staticMethod);
-                addCode("jmp 0 #skipMethod%d%d%d\n", dynType, staticClass, staticMethod);
-                addCode("#continueMethod%d%d%d: mov 0 0\n", dynType, staticClass, staticMethod);
-                int dynTargetClass, dynTargetMethod;
-                getDynamicMethod(staticClass, staticMethod, dynType, &dynTargetClass, &dynTargetMethod);
-                addCode("jmp 0 #CM%d%d ; go to resolved method\n", dynTargetClass, dynTargetMethod);
-                addCode("#skipMethod%d%d%d: mov 0 0\n", dynType, staticClass, staticMethod);
-            }
-            addCode("#skipClass%d%d: mov 0 0\n", dynType, staticClass);
-        }
-        addCode("#skipType%d: mov 0 0\n", dynType);
-    }
-    addCode("hlt 0; no matching method\n");
-}
-
-void generateDISM(FILE *outputFile){
-    // add all null dereference checks good20-22.dj
-    // make sure can handle disjunction operator good6.dj
-    fout = outputFile;
-    genPrologue(-1, -1);
-    codeGenExprs(mainExprs, -1, -1); 
-    genEpilogue(-1, -1);
-    for (int i = 0; i < numClasses; i++) {
-        for (int j = 0; j < classesST[i].numMethods; j++) {
-            genBody(i, j);
-        }
-    }
-    if (needVtable) {
-        genVtable();
-    }
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "codegen.h"
+#include "dism.h"
+#include "peephole.h"
+#include "symtbl.h"
+#include "recover.h"
+#include "timing.h"
+
+// Global to remember the next unique label number to use
+// (this state, like the DISM program in dism.h, is thread-local so
+// threads can generate code concurrently)
+_Thread_local unsigned int labelNumber = 0;
+_Thread_local int needVtable = 0; // flag to indicate if we need a vtable
+
+// The words the code generated so far for the current method or main
+// block has pushed below the SP it started with (its saved FP and
+// locals included), and the most it pushes at any point, which its
+// prologue checks there is room for.  maxDepthUses lists the
+// instructions that load that most (see emitMaxDepth()).
+_Thread_local int stackDepth = 0;
+_Thread_local int maxStackDepth = 0;
+static _Thread_local int *maxDepthUses = NULL;
+static _Thread_local int numMaxDepthUses = 0, maxDepthUsesCapacity = 0;
+
+// whether this thread evaluates expressions in registers where
+// possible (see useRegisters() in codegen.h)
+static _Thread_local int registerTemps = 1;
+
+// The registers genReg() may use for temporaries (below DISM's HP, SP
+// and FP registers)
+#define FIRST_TEMP_REG 1
+#define LAST_TEMP_REG 4
+
+// What planRegs() found for each node of the expression genReg()
+// evaluates, in preorder: its Sethi-Ullman number (the registers it
+// needs to be evaluated without spilling) and the size of its subtree
+typedef struct {
+    int need;
+    int size;
+} RegNode;
+static _Thread_local RegNode *regNodes = NULL;
+static _Thread_local int numRegNodes = 0, regNodesCapacity = 0;
+
+// declare mutually recursive functions (defs and docs appera below)
+void codeGenExpr (ASTree *t, int ClassNumber, int MethodNumber);
+void codeGenExprs(ASTree *expList, int ClassNumber, int MethodNumber);
+// print message and exit under an exceptional condition
+void internalCGerror(char *msg) {
+    fprintf(stderr, "Internal Code Generator Error: %s\n", msg);
+    compileFailed(1);
+}
+
+// offset within its object of the field a node's statics name
+// (see objectSize in symtbl.h)
+int fieldOffset(ASTree *t) {
+    return classesST[t->staticClassNum].fieldOffsets[t->staticMemberNum];
+}
+
+// slot number (see symtbl.h) of the method a call node's statics name
+int methodSlot(ASTree *t) {
+    return classesST[t->staticClassNum].methodList[t->staticMemberNum].slot;
+}
+
+// generate the jump that calls the method of call node t on a receiver
+// whose static class is receiverType: straight to the method when no
+// subclass of receiverType overrides it, else through the vtable
+void genCallJump(ASTree *t, int receiverType) {
+    MethodSlot *target = receiverType >= 0 ? &classesST[receiverType].slots[methodSlot(t)] : NULL;
+    if (target == NULL || target->overridden) {
+        needVtable = 1;
+        emitTo(DISM_JMP, 0, 0, label(LABEL_VTABLE, 0), NULL);
+    }
+    else emitTo(DISM_JMP, 0, 0, methodLabel(target->classNum, target->methodNum), "never overridden, so no dispatch");
+}
+
+// generate code that increments the stack pointer
+void incSP() {
+    emit(DISM_MOV, 1, 1, 0, NULL);
+    emit(DISM_ADD, 6, 6, 1, "#SP++");
+    stackDepth--;
+}
+// generate code that decrements the stack pointer (there is no check
+// here; genStackCheck() has made room for the deepest push)
+void decSP() {
+    emit(DISM_MOV, 1, 1, 0, NULL);
+    emit(DISM_SUB, 6, 6, 1, "#SP--");
+    if (++stackDepth > maxStackDepth) maxStackDepth = stackDepth;
+}
+
+// generate "mov reg D", where D is the current method or main block's
+// maxStackDepth; genEpilogue() fills D in once the body is generated
+void emitMaxDepth(int reg, const char *comment) {
+    if (numMaxDepthUses == maxDepthUsesCapacity) {
+        int capacity = maxDepthUsesCapacity ? 2 * maxDepthUsesCapacity : 64;
+        int *uses = realloc(maxDepthUses, sizeof(int) * capacity);
+        if (uses == NULL) internalCGerror("realloc failed in emitMaxDepth()");
+        maxDepthUses = uses;
+        maxDepthUsesCapacity = capacity;
+    }
+    maxDepthUses[numMaxDepthUses++] = dismLength;
+    emit(DISM_MOV, reg, 0, 0, comment);
+}
+
+// generate the one stack check of a method or main block, before it
+// pushes anything: halt with error 77 unless HP is below the lowest SP
+// it reaches, SP - maxStackDepth, which is left in r1
+void genStackCheck() {
+    emitMaxDepth(1, "r1 = most stack used");
+    emit(DISM_SUB, 1, 6, 1, "r1 = lowest SP");
+    emitTo(DISM_BLT, 5, 1, label(LABEL_NUM, labelNumber), "branch if HP<lowest SP");
+    emit(DISM_MOV, 1, 77, 0, "error code 77 no stack memory");
+    emit(DISM_HLT, 1, 0, 0, "out of stack memory!!");
+    emitLabel(label(LABEL_NUM, labelNumber), NULL);
+    labelNumber++;
+}
+
+// generate code that pushes the value of the variable the ID node t
+// names (as resolved by resolveNames(), see symtbl.h)
+void pushVar(ASTree *t) {
+    if (t->varKind == VAR_FIELD) {
+        emit(DISM_LOD, 1, 7, FRAME_THIS, "r1 = this");
+        emit(DISM_LOD, 1, 1, t->varOffset, "r1 = field");
+    }
+    else emit(DISM_LOD, 1, 7, t->varOffset, "r1 = variable");
+    emit(DISM_STR, 6, 0, 1, "push r1 on stack");
+    decSP();
+}
+
+// output code to check for a null value at the top of the stack
+// if the top stack value ast M(SP+1)) is null (0), the DISM code output will halt
+void checkNullDereference() {
+    emit(DISM_LOD, 1, 6, 1, "1 = M(SP+1)");
+    // check if loaded value is 0
+    emitTo(DISM_BEQ, 1, 0, label(LABEL_HALT, labelNumber), NULL);
+    emitTo(DISM_JMP, 0, 0, label(LABEL_NUM, labelNumber), NULL);
+    emitLabel(label(LABEL_HALT, labelNumber), NULL);
+    emit(DISM_MOV, 1, 77, 0, NULL);
+    emit(DISM_HLT, 1, 0, 0, "Null pointer dereference");
+    emitLabel(label(LABEL_NUM, labelNumber), NULL);
+    labelNumber++;
+}
+
+void useRegisters(int on) {
+    registerTemps = on;
+}
+
+int registersInUse(void) {
+    return registerTemps;
+}
+
+// generate code that pushes register r, using r itself (not r1, as
+// decSP() does) to adjust SP
+void pushReg(int r) {
+    emit(DISM_STR, 6, 0, r, "spill a temporary");
+    emit(DISM_MOV, r, 1, 0, NULL);
+    emit(DISM_SUB, 6, 6, r, "#SP--");
+    if (++stackDepth > maxStackDepth) maxStackDepth = stackDepth;
+}
+// generate code that pops the top of the stack into register r
+void popReg(int r) {
+    emit(DISM_MOV, r, 1, 0, NULL);
+    emit(DISM_ADD, 6, 6, r, "#SP++");
+    emit(DISM_LOD, r, 6, 0, "reload a spilled temporary");
+    stackDepth--;
+}
+
+// is t an operator genReg() can evaluate, given its operands?
+int isRegOperator(ASTree *t) {
+    switch (t->typ) {
+    case PLUS_EXPR: case MINUS_EXPR: case TIMES_EXPR: case EQUALITY_EXPR:
+    case LESS_THAN_EXPR: case OR_EXPR: case NOT_EXPR:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Append t's subtree to regNodes, in preorder.  Returns its Sethi-Ullman
+// number, or 0 (leaving regNodes as it was) if it cannot be evaluated
+// in registers: only operators over literals, null, this and variables
+// can, since their operands can then be evaluated in either order.
+static int planNode(ASTree *t) {
+    int at = numRegNodes;
+    if (numRegNodes == regNodesCapacity) {
+        int capacity = regNodesCapacity ? 2 * regNodesCapacity : 64;
+        RegNode *nodes = realloc(regNodes, sizeof(RegNode) * capacity);
+        if (nodes == NULL) internalCGerror("realloc failed in planNode()");
+        regNodes = nodes;
+        regNodesCapacity = capacity;
+    }
+    numRegNodes++;
+    int need = 0, left, right;
+    switch (t->typ) {
+    case NAT_LITERAL_EXPR: case NULL_EXPR: case THIS_EXPR: case ID_EXPR: case AST_ID:
+        need = 1;
+        break;
+    case NOT_EXPR:
+        need = planNode(t->children->data);
+        break;
+    default:
+        if (!isRegOperator(t)) break;
+        left = planNode(t->children->data);
+        right = left ? planNode(t->children->next->data) : 0;
+        if (left && right) need = left == right ? left + 1 : left > right ? left : right;
+        break;
+    }
+    if (need == 0) {
+        numRegNodes = at;
+        return 0;
+    }
+    regNodes[at].need = need;
+    regNodes[at].size = numRegNodes - at;
+    return need;
+}
+
+// plan the evaluation of t in registers; returns nonzero if genReg()
+// can then evaluate it
+int planRegs(ASTree *t) {
+    numRegNodes = 0;
+    return registerTemps && planNode(t) > 0;
+}
+
+// generate the end of a comparison whose branch to #true<n> is already
+// generated: register r = 1 if it branched, else 0
+void genTruthValue(int r, int n) {
+    emit(DISM_MOV, r, 0, 0, NULL);
+    emitTo(DISM_JMP, 0, 0, label(LABEL_END, n + 1), NULL);
+    emitLabel(label(LABEL_TRUE, n), NULL);
+    emit(DISM_MOV, r, 1, 0, "condition true");
+    emitLabel(label(LABEL_END, n + 1), NULL);
+}
+
+/* Generate code that leaves the value of t, which planRegs() has
+   planned (at index at of regNodes), in register r.  Uses only
+   registers r through LAST_TEMP_REG, and r must leave room for two
+   unless t is a leaf.  The operand needing more registers goes first,
+   so the other fits in the rest (Sethi-Ullman); only if both need more
+   than there are is the first one spilled to the stack meanwhile. */
+void genReg(ASTree *t, int at, int r) {
+    int outerLine = dismLine;
+    int n, first, second, leftReg, rightReg;
+    timedNodes++;
+    dismLine = t->lineNumber;
+    switch (t->typ) {
+    case NAT_LITERAL_EXPR:
+        emit(DISM_MOV, r, t->natVal, 0, NULL);
+        break;
+    case NULL_EXPR:
+        emit(DISM_MOV, r, 0, 0, "null");
+        break;
+    case THIS_EXPR:
+        emit(DISM_LOD, r, 7, FRAME_THIS, "this");
+        break;
+    case ID_EXPR: case AST_ID:
+        if (t->varKind == VAR_FIELD) {
+            emit(DISM_LOD, r, 7, FRAME_THIS, "this");
+            emit(DISM_LOD, r, r, t->varOffset, "field");
+        }
+        else emit(DISM_LOD, r, 7, t->varOffset, "variable");
+        break;
+    case NOT_EXPR:
+        genReg(t->children->data, at + 1, r);
+        n = labelNumber;
+        labelNumber += 2;
+        emitTo(DISM_BEQ, 0, r, label(LABEL_TRUE, n), "not is true");
+        genTruthValue(r, n);
+        break;
+    default: {
+        // index in regNodes of the left and right operands
+        int left = at + 1, right = at + 1 + regNodes[at + 1].size;
+        ASTList *operands = t->children;
+        int leftFirst = regNodes[left].need >= regNodes[right].need;
+        first = leftFirst ? left : right;
+        second = leftFirst ? right : left;
+        genReg(leftFirst ? operands->data : operands->next->data, first, r);
+        if (regNodes[second].need <= LAST_TEMP_REG - r) {
+            genReg(leftFirst ? operands->next->data : operands->data, second, r + 1);
+            leftReg = leftFirst ? r : r + 1;
+        } else {
+            pushReg(r);
+            genReg(leftFirst ? operands->next->data : operands->data, second, r);
+            popReg(r + 1);
+            leftReg = leftFirst ? r + 1 : r;
+        }
+        rightReg = leftReg == r ? r + 1 : r;
+        switch (t->typ) {
+        case PLUS_EXPR:
+            emit(DISM_ADD, r, leftReg, rightReg, NULL);
+            break;
+        case MINUS_EXPR:
+            emit(DISM_SUB, r, leftReg, rightReg, NULL);
+            break;
+        case TIMES_EXPR:
+            emit(DISM_MUL, r, leftReg, rightReg, NULL);
+            break;
+        case EQUALITY_EXPR: case LESS_THAN_EXPR:
+            n = labelNumber;
+            labelNumber += 2;
+            emitTo(t->typ == EQUALITY_EXPR ? DISM_BEQ : DISM_BLT, leftReg, rightReg,
+                   label(LABEL_TRUE, n), NULL);
+            genTruthValue(r, n);
+            break;
+        default: // OR_EXPR
+            n = labelNumber;
+            labelNumber += 4;
+            emitTo(DISM_BEQ, 0, leftReg, label(LABEL_NEXT, n), NULL);
+            emitTo(DISM_JMP, 0, 0, label(LABEL_TRUE, n + 1), NULL);
+            emitLabel(label(LABEL_NEXT, n), NULL);
+            emitTo(DISM_BEQ, 0, rightReg, label(LABEL_FALSE, n + 2), NULL);
+            emitLabel(label(LABEL_TRUE, n + 1), NULL);
+            emit(DISM_MOV, r, 1, 0, "condition true");
+            emitTo(DISM_JMP, 0, 0, label(LABEL_END, n + 3), NULL);
+            emitLabel(label(LABEL_FALSE, n + 2), NULL);
+            emit(DISM_MOV, r, 0, 0, "condition false");
+            emitLabel(label(LABEL_END, n + 3), NULL);
+            break;
+        }
+        break;
+    }
+    }
+    dismLine = outerLine;
+}
+
+// generate code that leaves the value of t in r1, in registers if
+// planRegs() allows, else through the stack; returns nonzero if t was
+// evaluated in registers, and so has not been pushed
+int genToR1(ASTree *t, int ClassNumber, int MethodNumber) {
+    if (planRegs(t)) {
+        genReg(t, 0, FIRST_TEMP_REG);
+        return 1;
+    }
+    codeGenExpr(t, ClassNumber, MethodNumber);
+    emit(DISM_LOD, 1, 6, 1, "load mem of r1");
+    return 0;
+}
+
+// generate code for the operands of binary operator t, leaving its
+// left operand in r1 and its right one in r2 and just one word, the
+// left operand's, pushed (where the result goes)
+void genOperands(ASTree *t, int ClassNumber, int MethodNumber) {
+    codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+    if (planRegs(t->children->next->data)) {
+        // the right operand needs no stack; r1 is free until it is done
+        genReg(t->children->next->data, 0, FIRST_TEMP_REG + 1);
+        emit(DISM_LOD, 1, 6, 1, "load mem of r1");
+        return;
+    }
+    codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
+    incSP();
+    emit(DISM_LOD, 1, 6, 1, "load mem of r1");
+    emit(DISM_LOD, 2, 6, 0, "load mem of r2");
+}
+
+/* generate DISM code for the given single expression, which appears in the given class and method (or maing block).
+if classNumber <0 then methodNumber may be anything and we assume
+we are generating code for the main block*/
+void codeGenExpr(ASTree *t, int ClassNumber, int MethodNumber) {
+    int trueLabel, falseLabel, endLabel, returnLabel, nextLabel, elseLabel, failLabel, passLabel, whileLabel;
+    int inRegister; // was an operand evaluated in r1 (see genToR1()), not pushed?
+    if (!t) return;
+    timedNodes++;
+    // every expression leaves exactly its value on the stack
+    int startDepth = stackDepth;
+    // tag the code for t with its line (see DismInstr in dism.h)
+    int outerLine = dismLine;
+    dismLine = t->lineNumber;
+    // an operator over operands that all fit in registers is evaluated
+    // there, and only its result pushed
+    if (isRegOperator(t) && planRegs(t)) {
+        genReg(t, 0, FIRST_TEMP_REG);
+        emit(DISM_STR, 6, 0, 1, "push the result");
+        decSP();
+    }
+    else switch (t->typ) {
+    case AST_ID:
+         pushVar(t);
+         break;
+
+    //level 3
+    case DOT_METHOD_CALL_EXPR:
+    returnLabel = labelNumber++;
+
+    // Push the return label onto the stack (see STACK FRAMES in symtbl.h)
+    emitTo(DISM_MOV, 1, 0, label(LABEL_RET, returnLabel), NULL);
+    emit(DISM_STR, 6, 0, 1, "push retLabel on stack");
+    decSP();
+
+    // pushes this on stack
+    codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+    checkNullDereference();
+
+    // Push the static class number onto the stack
+    emit(DISM_MOV, 1, t->staticClassNum, 0, NULL);
+    emit(DISM_STR, 6, 0, 1, "push class number on stack");
+    decSP();
+
+    // Push the method's slot number onto the stack
+    emit(DISM_MOV, 1, methodSlot(t), 0, NULL);
+    emit(DISM_STR, 6, 0, 1, "push method slot on stack");
+    decSP();
+
+    // Evaluate the method argument
+    codeGenExpr(t->children->next->next->data, ClassNumber, MethodNumber);
+
+    // Call the method, dispatching on the object's class if the
+    // receiver's static type (see staticType in ast.h) has overrides
+    genCallJump(t, t->children->data->staticType);
+
+    // Return label for after the method call; the method has popped
+    // all the call pushed but the result (see genEpilogue())
+    emitLabel(label(LABEL_RET, returnLabel), NULL);
+    stackDepth -= 4;
+    break;
+    
+    case METHOD_CALL_EXPR:
+        returnLabel = labelNumber++;
+        emitTo(DISM_MOV, 1, 0, label(LABEL_RET, returnLabel), NULL);
+        emit(DISM_STR, 6, 0, 1, "push retLabel on stack");
+        decSP();
+        
+        // pushes this (the caller) on stack
+        emit(DISM_LOD, 1, 7, FRAME_THIS, "r1 = this");
+        emit(DISM_STR, 6, 0, 1, "push this on stack");
+        decSP();
+
+        emit(DISM_MOV, 1, t->staticClassNum, 0, NULL);
+        emit(DISM_STR, 6, 0, 1, "push class number on stack");
+        decSP();
+        emit(DISM_MOV, 1, methodSlot(t), 0, NULL);
+        emit(DISM_STR, 6, 0, 1, "push method slot on stack");
+        decSP();
+         // leave on stack
+        codeGenExpr(t->children->next->data, ClassNumber, MethodNumber);
+        genCallJump(t, ClassNumber);
+        emitLabel(label(LABEL_RET, returnLabel), NULL);
+        stackDepth -= 4;
+        break;
+    
+    case DOT_ID_EXPR:
+    
+        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+        checkNullDereference();
+        incSP();
+        emit(DISM_LOD, 1, 6, 0, "load mem of r1");
+        emit(DISM_MOV, 2, fieldOffset(t), 0, "r2 = field offset");
+        emit(DISM_ADD, 1, 1, 2, "r1 = offset + base address");
+        emit(DISM_LOD, 1, 1, 0, "load mem at [A]");
+        emit(DISM_STR, 6, 0, 1, "push r1 on stack");
+        decSP();
+        break;
+    
+    case ID_EXPR: 
+        pushVar(t);
+        break;
+    
+    case DOT_ASSIGN_EXPR:
+        codeGenExpr(t->children->next->next->data, ClassNumber, MethodNumber);
+        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+        checkNullDereference();
+
+        emit(DISM_LOD, 1, 6, 1, "load base address of E1");
+        emit(DISM_MOV, 2, fieldOffset(t), 0, "r2 = field offset");
+        emit(DISM_ADD, 1, 1, 2, "r1 = offset + base address");
+        emit(DISM_STR, 6, 1, 1, "store A on stack");
+
+        emit(DISM_LOD, 1, 6, 1, "load address of A");
+        emit(DISM_LOD, 2, 6, 2, "load value of r");
+        emit(DISM_STR, 1, 0, 2, "store r at [A]");
+        // make sure we leave r on the stack only
+        incSP();
+        break;
+
+
+    case ASSIGN_EXPR:
+        // we can leave this value on stack
+        inRegister = genToR1(t->children->next->data, ClassNumber, MethodNumber);
+        if (t->varKind == VAR_FIELD) {
+            emit(DISM_LOD, 2, 7, FRAME_THIS, "r2 = this");
+            emit(DISM_STR, 2, t->varOffset, 1, "store r in field");
+        }
+        else emit(DISM_STR, 7, t->varOffset, 1, "store r in variable");
+        if (inRegister) {
+            emit(DISM_STR, 6, 0, 1, "push r");
+            decSP();
+        }
+        break;
+
+    case PLUS_EXPR:
+         genOperands(t, ClassNumber, MethodNumber);
+         emit(DISM_ADD, 1, 1, 2, "r1 = r1 + r2");
+         emit(DISM_STR, 6, 1, 1, "store result on top");
+         break;
+         
+    case MINUS_EXPR:
+         genOperands(t, ClassNumber, MethodNumber);
+         emit(DISM_SUB, 1, 1, 2, "r1 = r1 - r2");
+         emit(DISM_STR, 6, 1, 1, "store result on top");
+         break;
+
+    case TIMES_EXPR:
+         genOperands(t, ClassNumber, MethodNumber);
+         emit(DISM_MUL, 1, 1, 2, "r1 = r1 * r2");
+         emit(DISM_STR, 6, 1, 1, "store result on top");
+         break;
+
+    case EQUALITY_EXPR:
+         trueLabel = labelNumber++;
+         endLabel = labelNumber++;
+         genOperands(t, ClassNumber, MethodNumber);
+         emitTo(DISM_BEQ, 1, 2, label(LABEL_TRUE, trueLabel), NULL);
+         emit(DISM_MOV, 1, 0, 0, NULL);
+         emitTo(DISM_JMP, 0, 0, label(LABEL_END, endLabel), NULL);
+         emitLabel(label(LABEL_TRUE, trueLabel), NULL);
+         emit(DISM_MOV, 1, 1, 0, "condition true");
+         emitLabel(label(LABEL_END, endLabel), NULL);
+         emit(DISM_STR, 6, 1, 1, "return final result on stack");
+         break;
+
+    case LESS_THAN_EXPR:
+         trueLabel = labelNumber++;
+         endLabel = labelNumber++;
+         genOperands(t, ClassNumber, MethodNumber);
+         emitTo(DISM_BLT, 1, 2, label(LABEL_TRUE, trueLabel), NULL);
+         emit(DISM_MOV, 1, 0, 0, NULL);
+         emitTo(DISM_JMP, 0, 0, label(LABEL_END, endLabel), NULL);
+         emitLabel(label(LABEL_TRUE, trueLabel), NULL);
+         emit(DISM_MOV, 1, 1, 0, "condition true");
+         emitLabel(label(LABEL_END, endLabel), NULL);
+         emit(DISM_STR, 6, 1, 1, "return final result on stack");
+         break;
+
+    case NOT_EXPR:
+        trueLabel = labelNumber++;
+        endLabel = labelNumber++;
+        codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+        emit(DISM_LOD, 1, 6, 1, "load mem of r1");
+        emitTo(DISM_BEQ, 0, 1, label(LABEL_TRUE, trueLabel), "not is true");
+        emit(DISM_MOV, 1, 0, 0, NULL);
+        emitTo(DISM_JMP, 0, 0, label(LABEL_END, endLabel), "not is false");
+        emitLabel(label(LABEL_TRUE, trueLabel), "not is false");
+        emit(DISM_MOV, 1, 1, 0, "not is true");
+        emitLabel(label(LABEL_END, endLabel), NULL);
+        emit(DISM_STR, 6, 1, 1, "return final result on stack");
+        break;
+
+    case OR_EXPR:
+         nextLabel = labelNumber++;
+         trueLabel = labelNumber++;
+         falseLabel = labelNumber++;
+         endLabel = labelNumber++;
+         genOperands(t, ClassNumber, MethodNumber);
+         emitTo(DISM_BEQ, 0, 1, label(LABEL_NEXT, nextLabel), NULL);
+         emitTo(DISM_JMP, 0, 0, label(LABEL_TRUE, trueLabel), NULL);
+         emitLabel(label(LABEL_NEXT, nextLabel), "condition true");
+         emitTo(DISM_BEQ, 0, 2, label(LABEL_FALSE, falseLabel), NULL);
+         emitLabel(label(LABEL_TRUE, trueLabel), NULL);
+         emit(DISM_MOV, 1, 1, 0, "condition true");
+         emitTo(DISM_JMP, 0, 0, label(LABEL_END, endLabel), "jump to end");
+         emitLabel(label(LABEL_FALSE, falseLabel), NULL);
+         emit(DISM_MOV, 1, 0, 0, "condition false");
+         emitLabel(label(LABEL_END, endLabel), NULL);
+         emit(DISM_STR, 6, 1, 1, "return final result on stack");
+         break;
+        
+
+    case ASSERT_EXPR:
+         failLabel = labelNumber++;
+         passLabel = labelNumber++;
+         codeGenExpr(t->children->data, ClassNumber, MethodNumber);
+         // we can just leave this value on stack
+         emit(DISM_LOD, 1, 6, 1, "load mem of r1");
+         emitTo(DISM_BEQ, 0, 1, label(LABEL_FAIL, failLabel), NULL);
+         emitTo(DISM_JMP, 0, 0, label(LABEL_PASS, passLabel), NULL);
+         emitLabel(label(LABEL_FAIL, failLabel), NULL);
+         emit(DISM_HLT, 0, 0, 0, "assertion failed");
+         
+         emitLabel(label(LABEL_PASS, passLabel), "assertion passed");
+         break;
+
+    case IF_THEN_ELSE_EXPR:
+         elseLabel = labelNumber++;
+         endLabel = labelNumber++;
+         inRegister = genToR1(t->children->data, ClassNumber, MethodNumber);
+         emitTo(DISM_BEQ, 0, 1, label(LABEL_ELSE, elseLabel), NULL);
+         if (!inRegister) incSP();
+         codeGenExprs(t->children->next->data, ClassNumber, MethodNumber);
+         emitTo(DISM_JMP, 0, 0, label(LABEL_END, endLabel), NULL);
+         // the else branch pops the condition too, so both branches
+         // leave just their value
+         if (inRegister) stackDepth--;
+         emitLabel(label(LABEL_ELSE, elseLabel), NULL);
+         if (!inRegister) incSP();
+         codeGenExprs(t->children->next->next->data, ClassNumber, MethodNumber);
+         emitLabel(label(LABEL_END, endLabel), NULL);
+         break;
+
+    case WHILE_EXPR:
+        whileLabel = labelNumber++;
+        endLabel = labelNumber++;
+        emitLabel(label(LABEL_WHILE, whileLabel), NULL);
+        inRegister = genToR1(t->children->data, ClassNumber, MethodNumber);
+        // leave the loop with the false condition, 0, as its value
+        emitTo(DISM_BEQ, 0, 1, label(LABEL_END, endLabel), "condition not true");
+        // else pop the condition, and the body's value after it, so
+        // each iteration leaves the stack as it found it
+        if (!inRegister) incSP();
+        codeGenExprs(t->children->next->data, ClassNumber, MethodNumber);
+        incSP();
+        emitTo(DISM_JMP, 0, 0, label(LABEL_WHILE, whileLabel), "jump to start of while");
+        if (inRegister) {
+            emitLabel(label(LABEL_END, endLabel), NULL);
+            emit(DISM_STR, 6, 0, 0, "push the loop's value, 0");
+            decSP();
+        } else {
+            stackDepth++; // the condition is still on the stack at #end
+            emitLabel(label(LABEL_END, endLabel), NULL);
+        }
+        break;
+
+    case PRINT_EXPR:
+         // we can just leave this value on stack
+         inRegister = genToR1(t->children->data, ClassNumber, MethodNumber);
+         emit(DISM_PTN, 1, 0, 0, NULL);
+         if (inRegister) {
+             emit(DISM_STR, 6, 0, 1, "push the printed value");
+             decSP();
+         }
+         break;
+    case READ_EXPR:
+         emit(DISM_RDN, 1, 0, 0, "load input to r1");
+         emit(DISM_STR, 6, 0, 1, "store input at sp");
+         decSP();
+         break;
+    case THIS_EXPR:
+         emit(DISM_LOD, 1, 7, FRAME_THIS, "r1 = this");
+
+         emit(DISM_STR, 6, 0, 1, "push this on stack");
+         decSP();
+         break;
+    // level 3
+    case NEW_EXPR: {
+         // the whole object is one block of objectSize words
+         int objectSize = classesST[t->staticClassNum].objectSize;
+         //check HP + size < lowest SP
+        emit(DISM_MOV, 1, objectSize, 0, "r1 = object size");
+        emit(DISM_ADD, 1, 5, 1, "r1 = HP + object size");
+        // the object must stay below the lowest SP of every method
+        // still running (see STACK_LIMIT in symtbl.h)
+        emit(DISM_LOD, 2, 0, STACK_LIMIT, "r2 = stack limit");
+        emitTo(DISM_BLT, 1, 2, label(LABEL_GOODHP, labelNumber), NULL);
+        emit(DISM_MOV, 1, 77, 0, NULL);
+        emit(DISM_HLT, 1, 0, 0, "out of heap memory!!");
+        emitLabel(label(LABEL_GOODHP, labelNumber), NULL);
+        labelNumber++;
+
+         emit(DISM_MOV, 2, t->staticClassNum, 0, "R2 = new object type");
+         emit(DISM_STR, 5, OBJECT_HEADER, 2, "store the header");
+         for (int i = 0; i < objectSize; i++) {
+             if (i != OBJECT_HEADER) emit(DISM_STR, 5, i, 0, "field = 0");
+         }
+         emit(DISM_STR, 6, 0, 5, "push new-obj address");
+         emit(DISM_ADD, 5, 1, 0, "HP += object size");
+         decSP();
+         break;
+    }
+    case NULL_EXPR:
+         emit(DISM_STR, 6, 0, 0, "push null on stack");
+         decSP();
+         break;
+
+    case NAT_LITERAL_EXPR:
+        emit(DISM_MOV, 1, t->natVal, 0, NULL);
+        emit(DISM_STR, 6, 0, 1, "M[SP] <-R1 (a nat literal)");
+        decSP();
+        break;
+
+    default:
+        // declarations, types and lists are never expressions
+        internalCGerror("unexpected node type in codeGenExpr()");
+    }
+    if (stackDepth != startDepth + 1) internalCGerror("expression code left the stack unbalanced");
+    dismLine = outerLine;
+}
+/* GENERATE dism CODE FOR AN EXPRESSION LIST, WHICH APPEARS IN
+THE GIVEN CLASS AND METHOD or main block
+If classNumber <0 then methodNumber may be anything and we assume 
+we are generating code for the programs main block*/
+void codeGenExprs(ASTree *expList, int ClassNumber, int MethodNumber) {
+    ASTList *childIterator = expList->children;
+    while (childIterator != NULL) {
+        codeGenExpr(childIterator->data, ClassNumber, MethodNumber);
+        childIterator = childIterator->next;
+        if (childIterator != NULL) {
+            incSP();
+        }
+    }
+}
+
+/* generate DISM code as the prologue to the given method or main block. If classNumber < 0
+then methodNumber may be anything and we assume we are generating code for the progtrams main block*/
+void genPrologue(int ClassNumber, int MethodNumber) {
+    stackDepth = maxStackDepth = 0;
+    numMaxDepthUses = 0;
+    // For the main block
+    if (ClassNumber < 0) {
+        emit(DISM_MOV, 7, 65535, 0, "initialize FP");
+        emit(DISM_MOV, 6, 65535, 0, "initialize SP");
+        emit(DISM_MOV, 5, 1, 0, "initialize HP");
+        genStackCheck();
+        emit(DISM_STR, 0, STACK_LIMIT, 1, "stack limit = lowest SP");
+
+        // Allocate stack space for main block locals
+        for (int i = 0; i < numMainBlockLocals; i++) {
+            emit(DISM_STR, 6, 0, 0, "Allocate stack space for a main local");
+            decSP();
+        }
+
+        emit(DISM_MOV, 0, 0, 0, "BEGIN METHOD/MAIN-BLOCK BODY");
+    }
+    // For a method in a class (see STACK FRAMES in symtbl.h)
+    else {
+        genStackCheck();
+        // Lower the stack limit to this method's lowest SP, keeping the
+        // caller's in r2
+        emit(DISM_LOD, 2, 0, STACK_LIMIT, "r2 = caller's stack limit");
+        emitTo(DISM_BLT, 2, 1, label(LABEL_NUM, labelNumber), "branch if it is lower");
+        emit(DISM_STR, 0, STACK_LIMIT, 1, "stack limit = lowest SP");
+        emitLabel(label(LABEL_NUM, labelNumber), NULL);
+        labelNumber++;
+
+        // Save the old FP and point FP at it
+        emit(DISM_STR, 6, 0, 7, "Save old FP");
+        emit(DISM_ADD, 7, 6, 0, "FP = SP");
+        decSP();
+
+        // Allocate stack space for method locals
+        for (int i = 0; i < classesST[ClassNumber].methodList[MethodNumber].numLocals; i++) {
+            emit(DISM_STR, 6, 0, 0, "Allocate stack space for a method local");
+            decSP();
+        }
+
+        // Save the caller's stack limit after them
+        emit(DISM_STR, 6, 0, 2, "Save caller's stack limit");
+        decSP();
+    }
+}
+
+/*Generate DISM code as the epiliogue to the given method or main block. If classNumber <0 then methodNumber
+may be anything and we assume we are generating code for the program's main block*/
+void genEpilogue(int ClassNumber, int MethodNumber) {
+    // the body is done, so its most stack used is known
+    for (int i = 0; i < numMaxDepthUses; i++) dismCode[maxDepthUses[i]].imm = maxStackDepth;
+    numMaxDepthUses = 0;
+    if (ClassNumber < 0) {
+
+        emit(DISM_HLT, 0, 0, 0, "normal program termination");
+    }
+    else{
+        int savedLimit = FRAME_LOCALS - classesST[ClassNumber].methodList[MethodNumber].numLocals;
+        emit(DISM_LOD, 3, 7, savedLimit, "load caller's stack limit");
+        emit(DISM_STR, 0, STACK_LIMIT, 3, "restore it");
+        // the result replaces the return label, on top of the caller's stack
+        emit(DISM_LOD, 1, 6, 1, "load result");
+        emit(DISM_LOD, 2, 7, FRAME_RETURN, "load return label");
+        emit(DISM_STR, 7, FRAME_RETURN, 1, "store result in its place");
+        emit(DISM_MOV, 3, FRAME_RETURN - 1, 0, NULL);
+        emit(DISM_ADD, 6, 7, 3, "Restore caller's SP");
+        emit(DISM_LOD, 7, 7, 0, "Restore caller's FP");
+        emit(DISM_JMP, 2, 0, 0, "return to caller");
+    }
+}
+/* Generate DISM code for the given method or main block. 
+If classNumber < 0 then methodNumber may be anything and we assume we are generating code for the program's main block*/
+void genBody(int ClassNumber, int MethodNumber) {
+    emitLabel(methodLabel(ClassNumber, MethodNumber), NULL);
+
+    genPrologue(ClassNumber, MethodNumber);
+    codeGenExprs(classesST[ClassNumber].methodList[MethodNumber].bodyExprs, ClassNumber, MethodNumber);
+    genEpilogue(ClassNumber, MethodNumber);
+}
+/* Map a given (1) static class number, 2 a method number defined in that class,
+and (3) a dynamic object's type to: (a) the dynamic class number and (b)
+the dynamic method number that actually gets called when an object of type (3) dynamically invokes method(2).
+This method assumes that dynamicType is a subtype of staticClass*/
+void getDynamicMethod(int staticClass, int staticMethod, int dynamicType,
+    int *dynamicClassToCall, int *dynamicMethodToCall) {
+        // the method keeps its slot in every subclass (see symtbl.h)
+        int slot = classesST[staticClass].methodList[staticMethod].slot;
+        *dynamicClassToCall = classesST[dynamicType].slots[slot].classNum;
+        *dynamicMethodToCall = classesST[dynamicType].slots[slot].methodNum;
+}
+
+/*Emit code for the program's vtable, beginning at label #VTABLE.
+The vtable jumps (i.e., dispatches) to code based on
+(1) the dynamic calling object's address (at M(SP+4)), whose header
+    holds the object's dynamic class number, and
+(2) the method's slot number (at M(SP+2)); the calling object's static
+    type (at M(SP+3)) is not needed, since slots agree down the hierarchy.
+Each class's slots table gives the method to run for each slot, so the
+vtable is one test per class plus one per slot.*/
+void genVtable() {
+    emitLabel(label(LABEL_VTABLE, 0), NULL);
+    emit(DISM_LOD, 1, 6, 4, "load object address");
+    emitTo(DISM_BEQ, 1, 0, label(LABEL_VTNULL, 0), "halt on a null object");
+    emit(DISM_LOD, 1, 1, OBJECT_HEADER, "load dynamic class number from the header");
+    emit(DISM_LOD, 3, 6, 2, "load method slot number");
+    for(int dynType = 0; dynType < numClasses; dynType++) {
+        if (classesST[dynType].numSlots == 0) continue;
+        emit(DISM_MOV, 4, dynType, 0, "load class number");
+        emitTo(DISM_BEQ, 1, 4, label(LABEL_VTCLASS, dynType), "branch to class");
+    }
+    emit(DISM_HLT, 0, 0, 0, "no matching method");
+    for(int dynType = 0; dynType < numClasses; dynType++) {
+        if (classesST[dynType].numSlots == 0) continue;
+        emitLabel(label(LABEL_VTCLASS, dynType), NULL);
+        for(int slot = 0; slot < classesST[dynType].numSlots; slot++) {
+            MethodSlot *target = &classesST[dynType].slots[slot];
+            emit(DISM_MOV, 4, slot, 0, "load slot number");
+            emitTo(DISM_BEQ, 3, 4, methodLabel(target->classNum, target->methodNum), "go to resolved method");
+        }
+        emit(DISM_HLT, 0, 0, 0, "no matching method");
+    }
+    emitLabel(label(LABEL_VTNULL, 0), NULL);
+    emit(DISM_MOV, 1, 77, 0, NULL);
+    emit(DISM_HLT, 1, 0, 0, "Null pointer dereference");
+}
+
+void generateDISM(FILE *outputFile){
+    // add all null dereference checks good20-22.dj
+    // make sure can handle disjunction operator good6.dj
+    clearDism();
+    dismLine = 0;
+    labelNumber = 0;
+    needVtable = 0;
+    beginPhase("main block");
+    genPrologue(-1, -1);
+    codeGenExprs(mainExprs, -1, -1); 
+    genEpilogue(-1, -1);
+    endPhase();
+    beginPhase("genBody");
+    for (int i = 0; i < numClasses; i++) {
+        beginSpan(NULL, classesST[i].className);
+        for (int j = 0; j < classesST[i].numMethods; j++) {
+            beginSpan(classesST[i].className, classesST[i].methodList[j].methodName);
+            genBody(i, j);
+            endSpan();
+        }
+        endSpan();
+    }
+    endPhase();
+    if (needVtable) {
+        beginPhase("genVtable");
+        genVtable();
+        endPhase();
+    }
+    beginPhase("peephole");
+    optimizeDism();
+    endPhase();
+    beginPhase("write");
+    int writeFailed = writeDism(outputFile);
+    endPhase();
+    clearDism();
+    free(maxDepthUses);
+    maxDepthUses = NULL;
+    maxDepthUsesCapacity = 0;
+    free(regNodes);
+    regNodes = NULL;
+    regNodesCapacity = 0;
+    if (writeFailed) internalCGerror("could not write the DISM code");
 }
\ No newline at end of file
@@ -1,22 +1,40 @@
-/* File codegen.h: Header File for Code Generator for DJ compiler */
-
-#ifndef CODEGEN_H 
-#define CODEGEN_H
-
-#include <stdio.h>
-
-/* Perform code generation for the compiler's input program.
-   The code generation is based on the enhanced symbol tables built
-   in setupSymbolTables, which is declared in symtbl.h.
-
-   This method writes DISM code for the whole program to the 
-   specified outputFile (which must be open and ready for writes 
-   before calling generateDISM).
-
-   This method assumes that setupSymbolTables(), declared in 
-   symtbl.h, and typecheckProgram(), declared in typecheck.h, 
-   have already executed.
-*/
-void generateDISM(FILE *outputFile);
-
-#endif
+/* File codegen.h: Header File for Code Generator for DJ compiler */
+
+#ifndef CODEGEN_H 
+#define CODEGEN_H
+
+#include <stdio.h>
+
+/* Perform code generation for the compiler's input program.
+   The code generation is based on the enhanced symbol tables built
+   in setupSymbolTables, which is declared in symtbl.h.
+
+   This method writes DISM code for the whole program to the 
+   specified outputFile (which must be open and ready for writes 
+   before calling generateDISM).  The code is first built as an
+   array of instructions (see dism.h), improved by the peephole
+   optimizer (see peephole.h), and then printed in one pass.
+   Pushes are not checked one by one: each method and the main block
+   checks once, on entry, that the stack has room for the most it
+   pushes, and halts with error code 77 if not.
+
+   This method assumes that setupSymbolTables(), declared in 
+   symtbl.h, and typecheckProgram(), declared in typecheck.h, 
+   have already executed.
+*/
+void generateDISM(FILE *outputFile);
+
+/* Evaluate expressions in registers where possible (on, the default)
+   or always through the stack (on == 0).  Operators whose operands are
+   all literals, null, this, variables or such operators are evaluated
+   in r1-r4, spilling to the stack only when they need more registers
+   than that; so are the conditions of if and while and the operands of
+   printNat and assignments.  The setting belongs to the calling
+   thread; compileBatch() (see compile.h) gives its threads its
+   caller's. */
+void useRegisters(int on);
+
+/* Returns nonzero if this thread evaluates expressions in registers */
+int registersInUse(void);
+
+#endif
@@ -0,0 +1,557 @@
+/* File compile.c
+   Whole-program compilation driver for DJ
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "compile.h"
+#include "ast.h"
+#include "symtbl.h"
+#include "typecheck.h"
+#include "codegen.h"
+#include "peephole.h"
+#include "intern.h"
+#include "recover.h"
+#include "sha256.h"
+#include "timing.h"
+
+/* the compilation cache (see useCompileCache()), shared by all threads */
+static char *cacheDir = NULL;
+static size_t cacheMaxBytes = 0;
+/* Cache keys include the compiler's build id, so a rebuilt compiler
+   never reuses an old one's output, and the options that change the
+   code it generates.  Unless it is set at build time
+   with -DDJ_BUILD_ID=..., it is the SHA-256 of the running executable,
+   which changes whenever any source linked into it does. */
+static char buildId[2 * SHA256_BYTES + 1] = "";
+
+/* The options set by the use*() functions below.  Each thread has its
+   own, so threads in one process can compile with different options;
+   compileBatch() gives its threads a copy of its caller's. */
+typedef struct {
+    int typecheckThreads;  /* threads per program for typechecking */
+    FILE *timeReportOut;   /* where to print time reports, or NULL */
+    int writeTraces;       /* whether to write trace files */
+} CompileOptions;
+static _Thread_local CompileOptions options = { .typecheckThreads = 1 };
+
+/* One compileFile() call, as run under tryCompile() */
+typedef struct {
+    char *srcPath;
+    char *dismPath;
+    FILE *out;  /* the open DISM file, once there is one */
+    char cacheKey[2 * SHA256_BYTES + 1];  /* "" when not caching */
+    int cacheHit;
+} CompileJob;
+
+static int fetchCached(char *key, char *dismPath);
+
+static void runPhases(void *arg) {
+    CompileJob *job = arg;
+    int caching = cacheDir != NULL && !isASTFileName(job->srcPath);
+    Sha256 digest;
+    if (caching) {
+        sha256Init(&digest);
+        digestTokens(&digest);
+    }
+    beginPhase(isASTFileName(job->srcPath) ? "loadASTFile" : "parse");
+    ASTree *program = isASTFileName(job->srcPath)
+        ? loadASTFile(job->srcPath) : parseFile(job->srcPath, 0, 0);
+    endPhase();
+    if (caching) {
+        digestTokens(NULL);
+        sha256Update(&digest, buildId, strlen(buildId));
+        unsigned int peepholes = peepholesInUse();
+        sha256Update(&digest, &peepholes, sizeof peepholes);
+        int registers = registersInUse() != 0;
+        sha256Update(&digest, &registers, sizeof registers);
+        unsigned char hash[SHA256_BYTES];
+        sha256Final(&digest, hash);
+        for (int i = 0; i < SHA256_BYTES; i++)
+            sprintf(job->cacheKey + 2 * i, "%02x", hash[i]);
+        if (fetchCached(job->cacheKey, job->dismPath) == 0) {
+            job->cacheHit = 1;
+            return;
+        }
+    }
+    beginPhase("setupSymbolTables");
+    setupSymbolTables(program);
+    endPhase();
+    beginPhase("typecheck");
+    typecheckProgramParallel(options.typecheckThreads);
+    endPhase();
+
+    job->out = fopen(job->dismPath, "w");
+    if (job->out == NULL) {
+        printf("ERROR: could not open file %s\n", job->dismPath);
+        compileFailed(1);
+    }
+    beginPhase("generateDISM");
+    generateDISM(job->out);
+    endPhase();
+}
+
+/* Print and write the time report of the compile of srcPath to
+   dismPath, as useTimeReport() asked */
+static void reportTimes(char *srcPath, char *dismPath) {
+    stopTimeReport();
+    if (options.timeReportOut != NULL) {
+        flockfile(options.timeReportOut);
+        fprintf(options.timeReportOut, "%s: ", srcPath);
+        printTimeReport(options.timeReportOut);
+        funlockfile(options.timeReportOut);
+    }
+    if (options.writeTraces) {
+        size_t len = strlen(dismPath);
+        if (len >= 5 && strcmp(dismPath + len - 5, ".dism") == 0) len -= 5;
+        char *tracePath = malloc(len + 12);
+        if (tracePath == NULL) {
+            printf("ERROR: malloc failed in reportTimes()\n");
+            exit(-1);
+        }
+        memcpy(tracePath, dismPath, len);
+        strcpy(tracePath + len, ".trace.json");
+        writeTrace(tracePath);
+        free(tracePath);
+    }
+}
+
+static void storeCached(char *key, char *dismPath);
+
+int compileFile(char *srcPath, char *dismPath) {
+    CompileJob job = { srcPath, dismPath, NULL, "", 0 };
+    int timing = options.timeReportOut != NULL || options.writeTraces;
+    if (timing) startTimeReport(options.writeTraces);
+    int failed = tryCompile(runPhases, &job);
+    if (job.out != NULL) {
+        fclose(job.out);
+        if (failed) remove(dismPath);
+    }
+    if (failed) {
+        /* an error may have stopped the parse with the scanner mid-file */
+        finishSource();
+        digestTokens(NULL);
+    } else if (job.cacheKey[0] != '\0' && !job.cacheHit)
+        storeCached(job.cacheKey, dismPath);
+    /* the trace names classes and methods, so write it before the
+       names are released */
+    if (timing) reportTimes(srcPath, dismPath);
+
+    releaseSymbolTables();
+    releaseAST();
+    releaseNames();
+    return failed;
+}
+
+/* Copy file from to file to; returns 0 on success */
+static int copyFile(char *from, char *to) {
+    FILE *in = fopen(from, "rb");
+    if (in == NULL) return 1;
+    FILE *out = fopen(to, "wb");
+    if (out == NULL) {
+        fclose(in);
+        return 1;
+    }
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, in)) > 0) fwrite(buf, 1, n, out);
+    int failed = ferror(in) | ferror(out);
+    fclose(in);
+    if (fclose(out) != 0) failed = 1;
+    if (failed) remove(to);
+    return failed;
+}
+
+/* Take the cache's lock (an flock() on its stats file), returning the
+   locked file's descriptor, or -1 if it cannot be had.  Closing the
+   descriptor releases the lock. */
+static int lockCache(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof path, "%s/stats", cacheDir);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/* The stats file holds the hit and miss counts of every process
+   sharing the cache, as the text "HITS MISSES" */
+static void readCacheStats(int fd, unsigned long *hits, unsigned long *misses) {
+    char text[64];
+    ssize_t n = pread(fd, text, sizeof text - 1, 0);
+    *hits = *misses = 0;
+    if (n > 0) {
+        text[n] = '\0';
+        sscanf(text, "%lu %lu", hits, misses);
+    }
+}
+
+static void countLookup(int hit) {
+    int fd = lockCache();
+    if (fd < 0) return;
+    unsigned long hits, misses;
+    readCacheStats(fd, &hits, &misses);
+    if (hit) hits++;
+    else misses++;
+    char text[64];
+    int n = snprintf(text, sizeof text, "%lu %lu\n", hits, misses);
+    if (ftruncate(fd, 0) != 0 || pwrite(fd, text, n, 0) != n)
+        printf("ERROR: could not update %s/stats\n", cacheDir);
+    close(fd);
+}
+
+/* Copy the cache entry for key, if there is one, to dismPath.
+   Returns 0 on a hit. */
+static int fetchCached(char *key, char *dismPath) {
+    char path[PATH_MAX], tmpPath[PATH_MAX];
+    snprintf(path, sizeof path, "%s/%s.dism", cacheDir, key);
+    /* copied under a temporary name and renamed into place, so no
+       reader ever sees a partial output file */
+    snprintf(tmpPath, sizeof tmpPath, "%s.XXXXXX", dismPath);
+    int fd = mkstemp(tmpPath);
+    int hit = 0;
+    if (fd >= 0) {
+        close(fd);
+        hit = copyFile(path, tmpPath) == 0 && rename(tmpPath, dismPath) == 0;
+        if (!hit) remove(tmpPath);
+    }
+    /* entries are evicted least recently used first */
+    if (hit) utimensat(AT_FDCWD, path, NULL, 0);
+    countLookup(hit);
+    return hit ? 0 : 1;
+}
+
+/* One cache entry, as seen by evictCached() */
+typedef struct {
+    char name[2 * SHA256_BYTES + 6];
+    off_t size;
+    time_t lastUsed;
+} CacheEntry;
+
+static int byLastUse(const void *a, const void *b) {
+    const CacheEntry *x = a, *y = b;
+    return (x->lastUsed > y->lastUsed) - (x->lastUsed < y->lastUsed);
+}
+
+/* Remove least recently used entries until the cache is within its
+   size bound.  The caller holds the cache's lock. */
+static void evictCached(void) {
+    DIR *dir = opendir(cacheDir);
+    if (dir == NULL) return;
+    size_t numEntries = 0, capacity = 64;
+    CacheEntry *entries = malloc(sizeof(CacheEntry) * capacity);
+    if (entries == NULL) {
+        closedir(dir);
+        return;
+    }
+    size_t total = 0;
+    struct dirent *d;
+    char path[PATH_MAX];
+    while ((d = readdir(dir)) != NULL) {
+        size_t len = strlen(d->d_name);
+        struct stat st;
+        if (len != 2 * SHA256_BYTES + 5 || strcmp(d->d_name + len - 5, ".dism"))
+            continue;
+        snprintf(path, sizeof path, "%s/%s", cacheDir, d->d_name);
+        if (stat(path, &st) != 0) continue;
+        if (numEntries == capacity) {
+            CacheEntry *more = realloc(entries, sizeof(CacheEntry) * capacity * 2);
+            if (more == NULL) break;
+            entries = more;
+            capacity *= 2;
+        }
+        strcpy(entries[numEntries].name, d->d_name);
+        entries[numEntries].size = st.st_size;
+        entries[numEntries].lastUsed = st.st_mtime;
+        numEntries++;
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    qsort(entries, numEntries, sizeof(CacheEntry), byLastUse);
+    for (size_t i = 0; i < numEntries && total > cacheMaxBytes; i++) {
+        snprintf(path, sizeof path, "%s/%s", cacheDir, entries[i].name);
+        if (unlink(path) == 0) total -= entries[i].size;
+    }
+    free(entries);
+}
+
+/* Add the freshly compiled dismPath to the cache under key.
+   The entry is written under a temporary name and renamed into place,
+   so other processes never see a partial entry. */
+static void storeCached(char *key, char *dismPath) {
+    char tmpPath[PATH_MAX], path[PATH_MAX];
+    snprintf(tmpPath, sizeof tmpPath, "%s/tmp.XXXXXX", cacheDir);
+    snprintf(path, sizeof path, "%s/%s.dism", cacheDir, key);
+    int fd = mkstemp(tmpPath);
+    if (fd < 0) return;
+    close(fd);
+    if (copyFile(dismPath, tmpPath) != 0 || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return;
+    }
+    fd = lockCache();
+    if (fd < 0) return;
+    evictCached();
+    close(fd);
+}
+
+/* Set buildId (see above); returns 0 on success */
+static int setBuildId(void) {
+#ifdef DJ_BUILD_ID
+    snprintf(buildId, sizeof buildId, "%s", DJ_BUILD_ID);
+    return 0;
+#else
+    FILE *exe = fopen("/proc/self/exe", "rb");
+    if (exe == NULL) return 1;
+    Sha256 digest;
+    sha256Init(&digest);
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, exe)) > 0) sha256Update(&digest, buf, n);
+    int failed = ferror(exe);
+    fclose(exe);
+    unsigned char hash[SHA256_BYTES];
+    sha256Final(&digest, hash);
+    for (int i = 0; i < SHA256_BYTES; i++)
+        sprintf(buildId + 2 * i, "%02x", hash[i]);
+    return failed;
+#endif
+}
+
+void useCompileCache(char *dir, size_t maxBytes) {
+    if (setBuildId() != 0) {
+        printf("ERROR: could not read the compiler's executable; not caching\n");
+        return;
+    }
+    cacheDir = dir;
+    cacheMaxBytes = maxBytes;
+}
+
+void useTypecheckThreads(int numThreads) {
+    options.typecheckThreads = numThreads;
+}
+
+void useTimeReport(FILE *out, int traces) {
+    options.timeReportOut = out;
+    options.writeTraces = traces;
+}
+
+void printCacheStats(FILE *out) {
+    if (cacheDir == NULL) return;
+    int fd = lockCache();
+    if (fd < 0) return;
+    unsigned long hits, misses;
+    readCacheStats(fd, &hits, &misses);
+    close(fd);
+    fprintf(out, "cache %s: %lu hits, %lu misses\n", cacheDir, hits, misses);
+}
+
+char *dismPathFor(char *srcPath) {
+    size_t len = strlen(srcPath);
+    if (len >= 3 && strcmp(srcPath + len - 3, ".dj") == 0) len -= 3;
+    else if (isASTFileName(srcPath)) len -= 6;
+    char *path = malloc(len + 6);
+    if (path == NULL) {
+        printf("ERROR: malloc failed in dismPathFor()\n");
+        exit(-1);
+    }
+    memcpy(path, srcPath, len);
+    strcpy(path + len, ".dism");
+    return path;
+}
+
+/* Work shared by the threads of one compileBatch() call */
+typedef struct {
+    char **srcPaths;
+    int numFiles;
+    int nextFile;  /* index of the next file nobody has taken */
+    int failures;
+    pthread_mutex_t lock;
+    CompileOptions options;  /* compileBatch()'s caller's */
+    unsigned int peepholes;  /* and its usePeepholes() patterns */
+    int registers;           /* and useRegisters() setting */
+} BatchQueue;
+
+/* Thread body: keep taking the next file off the queue and compiling it */
+static void *batchWorker(void *arg) {
+    BatchQueue *queue = arg;
+    options = queue->options;
+    usePeepholes(queue->peepholes);
+    useRegisters(queue->registers);
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int i = queue->nextFile++;
+        pthread_mutex_unlock(&queue->lock);
+        if (i >= queue->numFiles) return NULL;
+
+        char *dismPath = dismPathFor(queue->srcPaths[i]);
+        if (compileFile(queue->srcPaths[i], dismPath) != 0) {
+            pthread_mutex_lock(&queue->lock);
+            queue->failures++;
+            pthread_mutex_unlock(&queue->lock);
+        }
+        free(dismPath);
+    }
+}
+
+int compileBatch(char **srcPaths, int numFiles, int numThreads) {
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > numFiles) numThreads = numFiles > 0 ? numFiles : 1;
+
+    BatchQueue queue = { .srcPaths = srcPaths, .numFiles = numFiles,
+                         .options = options, .peepholes = peepholesInUse(),
+                         .registers = registersInUse() };
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_t *threads = malloc(sizeof(pthread_t) * numThreads);
+    if (threads == NULL) {
+        printf("ERROR: malloc failed in compileBatch()\n");
+        exit(-1);
+    }
+    for (int t = 1; t < numThreads; t++) {
+        if (pthread_create(&threads[t], NULL, batchWorker, &queue) != 0) {
+            printf("ERROR: could not start compile thread\n");
+            exit(-1);
+        }
+    }
+    batchWorker(&queue);
+    for (int t = 1; t < numThreads; t++) pthread_join(threads[t], NULL);
+
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+    return queue.failures;
+}
+
+/* Copy the lines of in up to a line holding just "." into a new
+   temporary file, whose name is written to path.  The lines are read
+   even if they cannot be saved, so they are never taken for requests.
+   Returns 0 on success. */
+static int saveInlineSource(FILE *in, char *path) {
+    strcpy(path, "/tmp/djsourceXXXXXX");
+    int fd = mkstemp(path);
+    FILE *src = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (fd >= 0 && src == NULL) close(fd);
+    int failed = src == NULL;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    while ((len = getline(&line, &size, in)) > 0) {
+        if (strcmp(line, ".\n") == 0 || strcmp(line, ".") == 0) break;
+        if (src != NULL && fwrite(line, 1, len, src) != (size_t)len) failed = 1;
+    }
+    free(line);
+    if (src != NULL && fclose(src) != 0) failed = 1;
+    if (failed && fd >= 0) unlink(path);
+    return failed;
+}
+
+/* Returns a copy of text in newly malloc'd memory */
+static char *copyText(char *text) {
+    char *copy = strdup(text);
+    if (copy == NULL) {
+        printf("ERROR: malloc failed in serveCompiles()\n");
+        exit(-1);
+    }
+    return copy;
+}
+
+int serveCompiles(FILE *in) {
+    int failures = 0;
+    char *line = NULL;
+    size_t size = 0;
+    while (getline(&line, &size, in) > 0) {
+        char *command = strtok(line, " \t\r\n");
+        if (command == NULL) continue;
+        if (strcmp(command, "quit") == 0) break;
+        char *first = strtok(NULL, " \t\r\n");
+        char *second = strtok(NULL, " \t\r\n");
+
+        int failed = 1;
+        char *dismPath = NULL;
+        if (strcmp(command, "compile") == 0 && first != NULL) {
+            dismPath = second != NULL ? copyText(second) : dismPathFor(first);
+            failed = compileFile(first, dismPath);
+        } else if (strcmp(command, "source") == 0 && first != NULL) {
+            char srcPath[32];
+            dismPath = copyText(first);
+            if (saveInlineSource(in, srcPath) != 0)
+                printf("ERROR: could not save the program source\n");
+            else {
+                failed = compileFile(srcPath, dismPath);
+                unlink(srcPath);
+            }
+        } else printf("ERROR: bad request %s\n", command);
+
+        if (failed) {
+            printf("error\n");
+            failures++;
+        } else printf("ok %s\n", dismPath);
+        fflush(stdout);
+        free(dismPath);
+    }
+    free(line);
+    return failures;
+}
+
+int serveSocket(char *socketPath) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(socketPath) >= sizeof addr.sun_path) {
+        printf("ERROR: socket path %s is too long\n", socketPath);
+        return -1;
+    }
+    strcpy(addr.sun_path, socketPath);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 || bind(server, (struct sockaddr *)&addr, sizeof addr) != 0
+        || listen(server, 16) != 0) {
+        printf("ERROR: could not listen on socket %s\n", socketPath);
+        if (server >= 0) close(server);
+        return -1;
+    }
+    /* the replies and the compiler's messages go to stdout, and a few
+       internal errors go to stderr, so point both at each connection
+       while serving it; a client that goes away early must not kill the
+       server */
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+    fflush(stderr);
+    int savedStdout = dup(STDOUT_FILENO);
+    int savedStderr = dup(STDERR_FILENO);
+    int quit = 0;
+    while (!quit && savedStdout >= 0 && savedStderr >= 0) {
+        int conn = accept(server, NULL, NULL);
+        if (conn < 0) break;
+        FILE *in = fdopen(conn, "r");
+        if (in == NULL) {
+            close(conn);
+            continue;
+        }
+        dup2(conn, STDOUT_FILENO);
+        dup2(conn, STDERR_FILENO);
+        serveCompiles(in);
+        /* serveCompiles() stops at "quit" or when the client closes its
+           end; only a "quit" stops the server */
+        quit = !feof(in);
+        fflush(stdout);
+        dup2(savedStdout, STDOUT_FILENO);
+        dup2(savedStderr, STDERR_FILENO);
+        fclose(in);
+    }
+    if (savedStdout >= 0) close(savedStdout);
+    if (savedStderr >= 0) close(savedStderr);
+    close(server);
+    unlink(socketPath);
+    return 0;
+}
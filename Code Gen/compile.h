@@ -0,0 +1,98 @@
+/* File compile.h: Whole-program compilation driver for DJ */
+
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include <stdio.h>
+
+/* Run every phase of the compiler on the DJ program in file srcPath:
+   parseFile() (declared in ast.h), setupSymbolTables(),
+   typecheckProgram() and generateDISM(), writing the DISM code to
+   dismPath.  A srcPath ending in .djast is loaded with loadASTFile()
+   instead of being parsed.  Afterwards the AST, symbol tables and name table are all
+   released, so a thread may compile many programs in turn.
+   All compiler state is thread-local, so different threads may call
+   this at the same time.
+   Errors in the program do not exit the compiler (see recover.h): the
+   error message is printed, the partial output file is removed, the
+   compiler state is reset, and compileFile returns nonzero.
+   Returns 0 on success. */
+int compileFile(char *srcPath, char *dismPath);
+
+/* Returns (in newly malloc'd memory) the output path for srcPath:
+   its name with a trailing ".dj" or ".djast" replaced by ".dism" */
+char *dismPathFor(char *srcPath);
+
+/* Compile each of the numFiles programs named in srcPaths, writing each
+   to dismPathFor() its name, on a pool of numThreads threads (each
+   thread scans with its own scanner, flex's or the hand-written one).
+   Returns the number of files that could not be compiled. */
+int compileBatch(char **srcPaths, int numFiles, int numThreads);
+
+/* Cache compiled programs in the existing directory dir (or stop
+   caching, if dir is NULL); call before compiling anything.
+   With a cache, compileFile() looks each parsed program up by the
+   SHA-256 of its normalized token stream (see digestTokens() in ast.h)
+   plus the compiler's build id (the SHA-256 of the compiler's own
+   executable, or -DDJ_BUILD_ID=... if it was built with one; the
+   executable is read from /proc/self/exe, and without it nothing is
+   cached), its peephole patterns (see usePeepholes() in peephole.h)
+   and whether it uses registers (see useRegisters() in codegen.h).
+   On a hit the cached DISM code is
+   copied to the output file, skipping setupSymbolTables(),
+   typecheckProgram() and generateDISM(); on a miss the program is
+   compiled as usual and the output added to the cache.  Only
+   successful compiles of DJ source (not .djast files) are cached.
+   Any number of compiler processes may share one cache directory:
+   entries are written under temporary names and renamed into place,
+   and the shared hit/miss counts and evictions are serialized by an
+   flock() on dir/stats.  Whenever the entries total more than
+   maxBytes, the least recently used ones are removed. */
+void useCompileCache(char *dir, size_t maxBytes);
+
+/* Typecheck each program's method bodies on numThreads threads (see
+   typecheckProgramParallel() in typecheck.h); the default, 1,
+   typechecks serially.  Worth it for large programs compiled one at a
+   time, not for batches, which already use a thread per file.
+   The setting belongs to the calling thread (and the threads of the
+   compileBatch() calls it makes), so threads in one process may use
+   different settings. */
+void useTypecheckThreads(int numThreads);
+
+/* After each program compiled, print the time taken, allocations made,
+   AST nodes visited and DISM instructions emitted by each phase of the
+   compiler (see timing.h) to out, unless out is NULL; and if traces is
+   nonzero, write a Chrome trace of the compile, with a span per phase,
+   class and method, next to the DISM file, named as the DISM file but
+   ending .trace.json.  The default is neither.  Like
+   useTypecheckThreads(), this is a setting of the calling thread. */
+void useTimeReport(FILE *out, int traces);
+
+/* Print the cache's hit and miss counts, over every process that has
+   used it, to out */
+void printCacheStats(FILE *out);
+
+/* Compile server: read compile requests from in, one per line, until
+   end of input or a "quit" line, so one long-running process does the
+   work of many compiler invocations.  Requests are
+     compile SRC [DISM]   compile the file SRC, writing DISM code to
+                          DISM (by default, dismPathFor(SRC))
+     source DISM          compile the DJ program on the following
+                          lines, up to a line holding just ".", into DISM
+   Each reply goes to stdout: any messages the compiler printed (such as
+   the first syntax or type error), then a final line that is either
+   "ok DISM" or "error".
+   Returns the number of requests that failed. */
+int serveCompiles(FILE *in);
+
+/* Serve compile requests, as serveCompiles() does, to clients that
+   connect to a new Unix-domain socket at socketPath.  The clients are
+   served one at a time, each reading its replies from the connection;
+   that includes the messages the compiler writes to stderr (such as
+   internal code generator errors), which come before the reply line.
+   A client that closes its end lets the next one in; a "quit" request
+   also stops the server, which then removes the socket.
+   Returns nonzero if the socket could not be set up. */
+int serveSocket(char *socketPath);
+
+#endif
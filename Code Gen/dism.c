@@ -0,0 +1,259 @@
+/* File dism.c
+   In-memory DISM code for the DJ code generator, and its printer
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dism.h"
+#include "timing.h"
+
+_Thread_local DismInstr *dismCode = NULL;
+_Thread_local int dismLength = 0;
+_Thread_local int dismLine = 0;
+static _Thread_local int dismCapacity = 0;
+
+// the most text one number can print as
+#define MAX_NUMBER_TEXT 11
+// how much text to collect before writing it out
+#define TEXT_BLOCK_BYTES (1 << 20)
+// room for the longest line writeDism() prints, but for its comment
+#define MAX_LINE_TEXT 96
+
+static const char *opNames[] = {
+    "mov", "add", "sub", "mul", "jmp", "beq", "blt",
+    "lod", "str", "rdn", "ptn", "hlt", "mov"
+};
+
+// the text of each kind of label, before its number
+static const char *labelNames[] = {
+    "", "labelNum", "halt", "ret", "C", "VTABLE", "VTC", "VTNULL",
+    "goodHP", "true", "false", "end", "next", "else", "fail", "pass",
+    "while"
+};
+
+void clearDism(void) {
+    free(dismCode);
+    dismCode = NULL;
+    dismLength = dismCapacity = 0;
+}
+
+// append a blank instruction op, tagged with the current line
+static DismInstr *append(DismOp op) {
+    if (dismLength == dismCapacity) {
+        int capacity = dismCapacity ? 2 * dismCapacity : 4096;
+        DismInstr *code = realloc(dismCode, sizeof(DismInstr) * capacity);
+        if (code == NULL) {
+            printf("ERROR: realloc failed for the DISM code\n");
+            exit(-1);
+        }
+        dismCode = code;
+        dismCapacity = capacity;
+    }
+    DismInstr *instr = &dismCode[dismLength++];
+    memset(instr, 0, sizeof(DismInstr));
+    instr->op = op;
+    instr->line = dismLine;
+    timedInstructions++;
+    return instr;
+}
+
+void emit(DismOp op, int a, int b, int c, const char *comment) {
+    DismInstr *instr = append(op);
+    instr->comment = comment;
+    switch (op) {
+    case DISM_ADD: case DISM_SUB: case DISM_MUL:
+        instr->reg[2] = c;
+        // fall through
+    case DISM_LOD:
+        instr->reg[1] = b;
+        instr->reg[0] = a;
+        instr->imm = op == DISM_LOD ? c : 0;
+        break;
+    case DISM_STR:
+        instr->reg[0] = a;
+        instr->imm = b;
+        instr->reg[1] = c;
+        break;
+    case DISM_MOV: case DISM_JMP:
+        instr->reg[0] = a;
+        instr->imm = b;
+        break;
+    default:
+        instr->reg[0] = a;
+        break;
+    }
+}
+
+void emitTo(DismOp op, int a, int b, DismLabel target, const char *comment) {
+    DismInstr *instr = append(op);
+    instr->reg[0] = a;
+    instr->reg[1] = b;
+    instr->label = target;
+    instr->comment = comment;
+}
+
+void emitLabel(DismLabel l, const char *comment) {
+    DismInstr *instr = append(DISM_LABEL);
+    instr->label = l;
+    instr->comment = comment;
+}
+
+DismLabel label(LabelKind kind, int num) {
+    DismLabel l = { kind, num, 0 };
+    return l;
+}
+
+DismLabel methodLabel(int classNum, int methodNum) {
+    DismLabel l = { LABEL_METHOD, classNum, methodNum };
+    return l;
+}
+
+// TEXT OUTPUT, collected in a buffer and written out in large blocks
+
+static _Thread_local char *text = NULL;
+static _Thread_local size_t textLength = 0, textCapacity = 0;
+static _Thread_local FILE *textOut;
+static _Thread_local int textFailed;
+
+static void flushText(void) {
+    if (textLength > 0 && fwrite(text, 1, textLength, textOut) != textLength) textFailed = 1;
+    textLength = 0;
+}
+
+// make room for at least n more bytes of text
+static void reserveText(size_t n) {
+    if (textLength + n <= textCapacity) return;
+    flushText();
+    if (n <= textCapacity) return;
+    size_t capacity = TEXT_BLOCK_BYTES;
+    while (capacity < n) capacity *= 2;
+    char *buffer = realloc(text, capacity);
+    if (buffer == NULL) {
+        printf("ERROR: realloc failed for the DISM text\n");
+        exit(-1);
+    }
+    text = buffer;
+    textCapacity = capacity;
+}
+
+// append s (room must be reserved)
+static void appendString(const char *s, size_t n) {
+    memcpy(text + textLength, s, n);
+    textLength += n;
+}
+
+// append the decimal text of n (room must be reserved)
+static void appendDigits(long n) {
+    char digits[MAX_NUMBER_TEXT];
+    int count = 0;
+    unsigned long u = n < 0 ? -(unsigned long)n : (unsigned long)n;
+    if (n < 0) text[textLength++] = '-';
+    do {
+        digits[count++] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    while (count > 0) text[textLength++] = digits[--count];
+}
+
+// append an operand: a space and the decimal text of n
+static void appendNumber(long n) {
+    text[textLength++] = ' ';
+    appendDigits(n);
+}
+
+// append label l, with its '#' (room must be reserved)
+static void appendLabel(DismLabel l) {
+    text[textLength++] = '#';
+    appendString(labelNames[l.kind], strlen(labelNames[l.kind]));
+    if (l.kind == LABEL_VTABLE || l.kind == LABEL_VTNULL) return;
+    appendDigits(l.num);
+    if (l.kind == LABEL_METHOD) {
+        text[textLength++] = 'M';
+        appendDigits(l.num2);
+    }
+}
+
+// print instr, or the label definition on followed by instr if on is
+// not NULL, tagged with source line tagLine unless that is 0
+static void writeInstr(const DismInstr *instr, const DismInstr *on, int tagLine) {
+    const char *comment = instr->comment;
+    if (comment == NULL && on != NULL) comment = on->comment;
+    reserveText(MAX_LINE_TEXT + (comment ? strlen(comment) : 0));
+    if (instr->op == DISM_LABEL) {
+        appendLabel(instr->label);
+        appendString(": mov 0 0", 9);
+    } else {
+        if (on != NULL) {
+            appendLabel(on->label);
+            appendString(": ", 2);
+        }
+        else appendString("     ", 5);
+        appendString(opNames[instr->op], 3);
+        switch (instr->op) {
+        case DISM_ADD: case DISM_SUB: case DISM_MUL:
+            appendNumber(instr->reg[0]);
+            appendNumber(instr->reg[1]);
+            appendNumber(instr->reg[2]);
+            break;
+        case DISM_LOD:
+            appendNumber(instr->reg[0]);
+            appendNumber(instr->reg[1]);
+            appendNumber(instr->imm);
+            break;
+        case DISM_STR:
+            appendNumber(instr->reg[0]);
+            appendNumber(instr->imm);
+            appendNumber(instr->reg[1]);
+            break;
+        case DISM_BEQ: case DISM_BLT:
+            appendNumber(instr->reg[0]);
+            appendNumber(instr->reg[1]);
+            text[textLength++] = ' ';
+            appendLabel(instr->label);
+            break;
+        case DISM_MOV: case DISM_JMP:
+            appendNumber(instr->reg[0]);
+            if (instr->label.kind == LABEL_NONE) appendNumber(instr->imm);
+            else {
+                text[textLength++] = ' ';
+                appendLabel(instr->label);
+            }
+            break;
+        default:
+            appendNumber(instr->reg[0]);
+            break;
+        }
+    }
+    if (tagLine != 0 || comment != NULL) appendString(" ; ", 3);
+    if (tagLine != 0) {
+        appendString("line", 4);
+        appendNumber(tagLine);
+        if (comment != NULL) appendString(": ", 2);
+    }
+    if (comment != NULL) appendString(comment, strlen(comment));
+    text[textLength++] = '\n';
+}
+
+int writeDism(FILE *out) {
+    textOut = out;
+    textLength = 0;
+    textFailed = 0;
+    int lastLine = 0;
+    for (int i = 0; i < dismLength; i++) {
+        const DismInstr *instr = &dismCode[i], *on = NULL;
+        if (instr->op == DISM_LABEL && instr->imm && i + 1 < dismLength
+            && dismCode[i + 1].op != DISM_LABEL) {
+            on = instr;
+            instr = &dismCode[++i];
+        }
+        int line = instr->line;
+        writeInstr(instr, on, line != lastLine ? line : 0);
+        lastLine = line;
+    }
+    flushText();
+    free(text);
+    text = NULL;
+    textCapacity = 0;
+    return textFailed;
+}
@@ -0,0 +1,110 @@
+/* File dism.h: In-memory DISM code for the DJ code generator */
+
+#ifndef DISM_H
+#define DISM_H
+
+#include <stdio.h>
+
+/* generateDISM() (see codegen.h) does not write text as it goes.  It
+   appends instructions to this thread's DISM program, an array of
+   DismInstr, which later passes may inspect and rewrite before
+   writeDism() prints it in .dism syntax. */
+
+/* DISM's instructions, plus DISM_LABEL, which defines a label (and is
+   printed as "#label: mov 0 0", so it is also a no-op instruction,
+   unless it is put on the next instruction; see DismInstr) */
+typedef enum {
+  DISM_MOV,  /* mov r1 n      r1 = n (n is an immediate or a label) */
+  DISM_ADD,  /* add r1 r2 r3  r1 = r2 + r3 */
+  DISM_SUB,  /* sub r1 r2 r3  r1 = r2 - r3 */
+  DISM_MUL,  /* mul r1 r2 r3  r1 = r2 * r3 */
+  DISM_JMP,  /* jmp r1 n      go to r1 + n (n an immediate or label) */
+  DISM_BEQ,  /* beq r1 r2 L   go to L if r1 == r2 */
+  DISM_BLT,  /* blt r1 r2 L   go to L if r1 < r2 */
+  DISM_LOD,  /* lod r1 r2 n   r1 = M[r2 + n] */
+  DISM_STR,  /* str r1 n r2   M[r1 + n] = r2 */
+  DISM_RDN,  /* rdn r1        read a nat into r1 */
+  DISM_PTN,  /* ptn r1        print r1 */
+  DISM_HLT,  /* hlt r1        halt with status r1 */
+  DISM_LABEL
+} DismOp;
+
+/* Kinds of labels; a label is its kind plus one or two numbers */
+typedef enum {
+  LABEL_NONE,
+  LABEL_NUM,     /* #labelNum<n>: after a stack or null check, or a
+                    stack limit update */
+  LABEL_HALT,    /* #halt<n>: a failed null check */
+  LABEL_RET,     /* #ret<n>: return point of a call */
+  LABEL_METHOD,  /* #C<class>M<method>: a method body */
+  LABEL_VTABLE,  /* #VTABLE */
+  LABEL_VTCLASS, /* #VTC<class>: the vtable's tests for one class */
+  LABEL_VTNULL,  /* #VTNULL */
+  LABEL_GOODHP,  /* #goodHP<n>: after a heap check */
+  LABEL_TRUE,    /* #true<n>, #false<n>, #end<n>, #next<n>: parts of */
+  LABEL_FALSE,   /*   the code for a condition */
+  LABEL_END,
+  LABEL_NEXT,
+  LABEL_ELSE,    /* #else<n> */
+  LABEL_FAIL,    /* #fail<n>, #pass<n>: the outcomes of an assert */
+  LABEL_PASS,
+  LABEL_WHILE,   /* #while<n> */
+  NUM_LABEL_KINDS
+} LabelKind;
+
+typedef struct {
+  unsigned char kind;  /* a LabelKind */
+  int num;             /* its number (the class, for LABEL_METHOD) */
+  int num2;            /* the method, for LABEL_METHOD */
+} DismLabel;
+
+/* One instruction.  Registers are named in reg in the order they are
+   written; imm is the immediate (for mov, jmp, lod and str) unless
+   label.kind is not LABEL_NONE, in which case the label is the operand
+   (for mov, jmp, beq and blt) or, for DISM_LABEL, the label defined.
+   A DISM_LABEL whose imm is nonzero is printed on the instruction
+   after it rather than on a "mov 0 0" of its own. */
+typedef struct {
+  unsigned char op;      /* a DismOp */
+  unsigned char reg[3];
+  int imm;
+  DismLabel label;
+  int line;              /* the source line the code is for, or 0 */
+  const char *comment;   /* static text printed after it, or NULL */
+} DismInstr;
+
+/* This thread's DISM program (valid until the next append) */
+extern _Thread_local DismInstr *dismCode;
+extern _Thread_local int dismLength;
+
+/* The source line tagged on instructions appended from now on */
+extern _Thread_local int dismLine;
+
+/* Forget this thread's DISM program */
+void clearDism(void);
+
+/* Append an instruction op with up to three register or immediate
+   operands, a, b and c, in the order DISM writes them (unused ones are
+   ignored); comment may be NULL */
+void emit(DismOp op, int a, int b, int c, const char *comment);
+
+/* Append an instruction whose last operand is label target: mov or jmp
+   with register a, or beq or blt comparing registers a and b */
+void emitTo(DismOp op, int a, int b, DismLabel target, const char *comment);
+
+/* Append the definition of label l */
+void emitLabel(DismLabel l, const char *comment);
+
+/* Returns the label of kind kind and number num */
+DismLabel label(LabelKind kind, int num);
+
+/* Returns the label of method methodNum of class classNum */
+DismLabel methodLabel(int classNum, int methodNum);
+
+/* Write this thread's DISM program to out in .dism syntax, one
+   instruction per line.  The first instruction for each new source
+   line has "line N" in its comment.  Returns 0 on success and nonzero
+   if the output could not be written. */
+int writeDism(FILE *out);
+
+#endif
@@ -0,0 +1,87 @@
+/* File djc.c: the DJ compiler's command line
+
+   Compiles each DJ program named on the command line to DISM code, or
+   serves compile requests (see compile.h).  Build with every stage's
+   sources and the parser, leaving out parsedj's main():
+     bison -b dj Typechecker/dj.y
+     gcc -O2 -DNO_PARSEDJ_MAIN -ITypechecker -I"Code Gen" "Code Gen/djc.c"
+         "Code Gen/compile.c" "Code Gen/codegen.c" "Code Gen/dism.c"
+         "Code Gen/peephole.c"
+         dj.tab.c Typechecker/ast.c Typechecker/symtbl.c Typechecker/typecheck.c
+         Typechecker/intern.c Typechecker/arena.c Typechecker/recover.c
+         Typechecker/sha256.c Typechecker/timing.c
+         -lpthread -o djc
+   (plus lex.yy.c from flex, or -DHANDSCAN -I"Parser & Lexer" and the
+   hand-written scanner).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compile.h"
+#include "codegen.h"
+#include "peephole.h"
+
+static void usage(void) {
+  printf("Usage: djc [-threads N] [-tcthreads N] [-times] [-traces]\n"
+         "           [-peepholes MASK] [-noregisters]\n"
+         "           [-cache DIR [-cachemax MB] [-cachestats]]\n"
+         "           (-serve | -socket PATH | files...)\n");
+  exit(-1);
+}
+
+int main(int argc, char **argv) {
+  /* Options:
+     -threads N    compile the files on N threads (compileBatch())
+     -tcthreads N  typecheck each program on N threads
+                   (useTypecheckThreads())
+     -times        print each compile's time report (useTimeReport())
+     -traces       write each compile's Chrome trace next to its DISM
+     -peepholes MASK  apply only the peephole patterns in MASK
+                   (usePeepholes(); 0 turns the optimizer off)
+     -noregisters  evaluate every expression through the stack
+                   (useRegisters(0))
+     -serve        serve compile requests from stdin
+     -socket PATH  serve compile requests on a Unix socket at PATH
+     -cache DIR    cache compiled programs in the directory DIR
+     -cachemax MB  keep the cache under MB megabytes (default 64)
+     -cachestats   print the cache's hit and miss counts when done
+     Each file FILE.dj is compiled to FILE.dism.
+     The exit status is the number of programs that failed. */
+  int threads = 1, tcThreads = 1, times = 0, traces = 0, serve = 0;
+  char *socketPath = NULL, *cacheDir = NULL;
+  long cacheMaxMB = 64;
+  int cacheStats = 0;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    int hasValue = arg + 1 < argc;
+    if (strcmp(argv[arg], "-threads") == 0 && hasValue) threads = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-tcthreads") == 0 && hasValue) tcThreads = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-times") == 0) times = 1;
+    else if (strcmp(argv[arg], "-traces") == 0) traces = 1;
+    else if (strcmp(argv[arg], "-peepholes") == 0 && hasValue)
+      usePeepholes(strtoul(argv[++arg], NULL, 0));
+    else if (strcmp(argv[arg], "-noregisters") == 0) useRegisters(0);
+    else if (strcmp(argv[arg], "-serve") == 0) serve = 1;
+    else if (strcmp(argv[arg], "-socket") == 0 && hasValue) socketPath = argv[++arg];
+    else if (strcmp(argv[arg], "-cache") == 0 && hasValue) cacheDir = argv[++arg];
+    else if (strcmp(argv[arg], "-cachemax") == 0 && hasValue) cacheMaxMB = atol(argv[++arg]);
+    else if (strcmp(argv[arg], "-cachestats") == 0) cacheStats = 1;
+    else usage();
+  }
+  int numFiles = argc - arg;
+  if (threads < 1 || tcThreads < 1 || (serve || socketPath != NULL) == (numFiles > 0)
+      || (serve && socketPath != NULL) || cacheMaxMB < 1
+      || (cacheDir == NULL && cacheStats))
+    usage();
+  useTypecheckThreads(tcThreads);
+  if (times || traces) useTimeReport(times ? stdout : NULL, traces);
+  if (cacheDir != NULL) useCompileCache(cacheDir, (size_t)cacheMaxMB << 20);
+
+  int failures;
+  if (serve) failures = serveCompiles(stdin);
+  else if (socketPath != NULL) failures = serveSocket(socketPath) != 0;
+  else failures = compileBatch(argv + arg, numFiles, threads);
+  if (cacheStats) printCacheStats(stdout);
+  return failures > 255 ? 255 : failures;
+}
@@ -0,0 +1,444 @@
+/* File peephole.c
+   Peephole optimizations of the DISM code built by the code generator
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "peephole.h"
+#include "dism.h"
+#include "timing.h"
+
+#define NUM_PATTERNS 4
+#define PUSH_POP 0
+#define CONSTANTS 1
+#define JUMP_OVER 2
+#define LABELS 3
+
+static const char *patternNames[NUM_PATTERNS] = {
+    "push-pop", "constants", "jump-over", "labels"
+};
+
+// the patterns to apply on this thread (see usePeepholes())
+static _Thread_local unsigned int enabledPatterns = PEEP_ALL;
+
+// hits and instructions removed per pattern over every thread, and for
+// the program being optimized on this thread
+static unsigned long totalHits[NUM_PATTERNS], totalRemoved[NUM_PATTERNS];
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local unsigned long hits[NUM_PATTERNS], removed[NUM_PATTERNS];
+
+// the most instructions of halting code PEEP_JUMP_OVER moves, and the
+// most different pieces of it one program may have
+#define MAX_HALT_CODE 4
+#define MAX_HALT_BLOCKS 8
+
+// what is known about one label of the program
+typedef struct {
+    DismLabel label;
+    int refs;          // instructions naming it as an operand
+    int branchRefs;    // of those, the beq, blt and "jmp 0" ones
+    int addressTaken;  // named by some other instruction (such as the
+                       // mov of a return label), so a computed jmp may
+                       // reach it
+    int seenBranches;  // branches to it passed so far (constants())
+} LabelInfo;
+
+// the labels; the index in labels of the one of kind k with key n
+// (see labelKey()) is labelIndex[kindBase[k] + n], or -1 if none
+static _Thread_local LabelInfo *labels;
+static _Thread_local int numLabels;
+static _Thread_local int *labelIndex;
+static _Thread_local int kindBase[NUM_LABEL_KINDS];
+static _Thread_local int methodStride;
+
+// what is known about the registers at some point in the program
+typedef struct {
+    int reachable;
+    unsigned int known;  // bit r set if register r's value is known
+    int value[8];
+} RegState;
+
+void usePeepholes(unsigned int patterns) {
+    enabledPatterns = patterns;
+}
+
+unsigned int peepholesInUse(void) {
+    return enabledPatterns;
+}
+
+static int sameLabel(DismLabel a, DismLabel b) {
+    return a.kind == b.kind && a.num == b.num && a.num2 == b.num2;
+}
+
+// a number for label l that no other label of its kind has
+static int labelKey(DismLabel l) {
+    return l.kind == LABEL_METHOD ? l.num * methodStride + l.num2 : l.num;
+}
+
+// index in labels of label l, which is added if it is new
+static int findLabel(DismLabel l) {
+    int *index = &labelIndex[kindBase[l.kind] + labelKey(l)];
+    if (*index < 0) {
+        memset(&labels[numLabels], 0, sizeof(LabelInfo));
+        labels[numLabels].label = l;
+        *index = numLabels++;
+    }
+    return *index;
+}
+
+// does instr go to its label operand, if it has one, only as a branch?
+static int isBranch(const DismInstr *instr) {
+    return instr->op == DISM_BEQ || instr->op == DISM_BLT
+        || (instr->op == DISM_JMP && instr->reg[0] == 0);
+}
+
+// does control never go on from instr to the next instruction?
+static int endsFlow(const DismInstr *instr) {
+    return instr->op == DISM_JMP || instr->op == DISM_HLT;
+}
+
+// find every label of the program, and count the references to each
+static void findLabels(void) {
+    int bound = 0;
+    int maxNum[NUM_LABEL_KINDS];
+    memset(maxNum, -1, sizeof maxNum);
+    methodStride = 1;
+    for (int i = 0; i < dismLength; i++) {
+        DismLabel l = dismCode[i].label;
+        if (l.kind == LABEL_NONE) continue;
+        bound++;
+        if (l.num > maxNum[l.kind]) maxNum[l.kind] = l.num;
+        if (l.kind == LABEL_METHOD && l.num2 >= methodStride) methodStride = l.num2 + 1;
+    }
+    size_t size = 0;
+    for (int k = 0; k < NUM_LABEL_KINDS; k++) {
+        kindBase[k] = size;
+        size += (maxNum[k] + 1) * (k == LABEL_METHOD ? methodStride : 1);
+    }
+    labels = malloc(sizeof(LabelInfo) * (bound + 1));
+    labelIndex = malloc(sizeof(int) * (size + 1));
+    if (labels == NULL || labelIndex == NULL) {
+        printf("ERROR: malloc failed in the peephole optimizer\n");
+        exit(-1);
+    }
+    memset(labelIndex, -1, sizeof(int) * size);
+    numLabels = 0;
+    for (int i = 0; i < dismLength; i++) {
+        DismInstr *instr = &dismCode[i];
+        if (instr->label.kind == LABEL_NONE) continue;
+        LabelInfo *info = &labels[findLabel(instr->label)];
+        if (instr->op == DISM_LABEL) continue;
+        info->refs++;
+        if (isBranch(instr)) info->branchRefs++;
+        else info->addressTaken = 1;
+    }
+}
+
+// stop naming instr's label (if any) from instr
+static void dropRef(DismInstr *instr) {
+    if (instr->label.kind == LABEL_NONE || instr->op == DISM_LABEL) return;
+    LabelInfo *info = &labels[findLabel(instr->label)];
+    info->refs--;
+    if (isBranch(instr)) info->branchRefs--;
+}
+
+// leave out instruction i, removed by pattern
+static void dropInstr(int i, int pattern) {
+    dropRef(&dismCode[i]);
+    removed[pattern]++;
+}
+
+static int isMov(const DismInstr *instr, int r, int n) {
+    return instr->op == DISM_MOV && instr->label.kind == LABEL_NONE
+        && instr->reg[0] == r && instr->imm == n;
+}
+
+static int isArith(const DismInstr *instr, int op, int a, int b, int c) {
+    return instr->op == op && instr->reg[0] == a && instr->reg[1] == b
+        && instr->reg[2] == c;
+}
+
+// length of the SP-- code decSP() generates, if it starts at i, or 0
+static int matchDecSP(int i) {
+    if (i + 2 > dismLength) return 0;
+    DismInstr *c = &dismCode[i];
+    return isMov(&c[0], 1, 1) && isArith(&c[1], DISM_SUB, 6, 6, 1) ? 2 : 0;
+}
+
+// length of the SP++ code incSP() generates, if it starts at i, or 0
+static int matchIncSP(int i) {
+    if (i + 2 > dismLength) return 0;
+    DismInstr *c = &dismCode[i];
+    return isMov(&c[0], 1, 1) && isArith(&c[1], DISM_ADD, 6, 6, 1) ? 2 : 0;
+}
+
+static int readsReg(const DismInstr *instr, int r) {
+    switch (instr->op) {
+    case DISM_ADD: case DISM_SUB: case DISM_MUL:
+        return instr->reg[1] == r || instr->reg[2] == r;
+    case DISM_LOD:
+        return instr->reg[1] == r;
+    case DISM_STR: case DISM_BEQ: case DISM_BLT:
+        return instr->reg[0] == r || instr->reg[1] == r;
+    case DISM_JMP: case DISM_PTN: case DISM_HLT:
+        return instr->reg[0] == r;
+    default:
+        return 0;
+    }
+}
+
+static int writesReg(const DismInstr *instr, int r) {
+    switch (instr->op) {
+    case DISM_MOV: case DISM_ADD: case DISM_SUB: case DISM_MUL:
+    case DISM_LOD: case DISM_RDN:
+        return instr->reg[0] == r;
+    default:
+        return 0;
+    }
+}
+
+// might the value register r holds before instruction i be read?
+// (only looks along straight-line code, assuming so at a jump)
+static int regLive(int i, int r) {
+    for (; i < dismLength; i++) {
+        DismInstr *instr = &dismCode[i];
+        if (instr->op == DISM_LABEL) continue;
+        if (readsReg(instr, r)) return 1;
+        if (writesReg(instr, r)) return 0;
+        if (instr->op == DISM_HLT) return 0;
+        if (endsFlow(instr) || isBranch(instr)) return 1;
+    }
+    return 0;
+}
+
+// Each pattern's pass moves the instructions it keeps down over those
+// it leaves out as it goes, keeping kept <= i, so the code ahead of
+// instruction i is still as it was.
+
+// PEEP_PUSH_POP: "str 6 0 r", SP--, SP++ becomes "str 6 0 r" (the
+// value stays below SP, where later code may still load it), plus
+// "mov 1 1" if r1 might be read before it is set again
+static void pushPop(void) {
+    int kept = 0;
+    for (int i = 0; i < dismLength; i++) {
+        DismInstr *instr = &dismCode[i];
+        dismCode[kept++] = *instr;
+        if (instr->op != DISM_STR || instr->reg[0] != 6 || instr->imm != 0) continue;
+        int dec = matchDecSP(i + 1);
+        if (dec == 0 || matchIncSP(i + 1 + dec) == 0) continue;
+        int inc = i + 1 + dec;
+        int keepOne = regLive(inc + 2, 1);
+        for (int j = i + 1; j < inc + 2; j++) {
+            if (j == inc && keepOne) dismCode[kept++] = dismCode[j];
+            else dropInstr(j, PUSH_POP);
+        }
+        hits[PUSH_POP]++;
+        i = inc + 1;
+    }
+    dismLength = kept;
+}
+
+// PEEP_JUMP_OVER: see peephole.h
+static void jumpOver(void) {
+    // the halting code moved so far; blocks[b][0] defines its label
+    DismInstr blocks[MAX_HALT_BLOCKS][MAX_HALT_CODE + 1];
+    int blockLength[MAX_HALT_BLOCKS];
+    int numBlocks = 0;
+    // the moved code goes after the end, so the end must not fall
+    // through to it
+    if (dismLength == 0 || !endsFlow(&dismCode[dismLength - 1])) return;
+    int kept = 0;
+    for (int i = 0; i < dismLength; i++) {
+        DismInstr *c = &dismCode[i];
+        dismCode[kept++] = c[0];
+        if (i + 4 >= dismLength || (c[0].op != DISM_BEQ && c[0].op != DISM_BLT)
+            || c[1].op != DISM_JMP || c[1].reg[0] != 0 || c[1].label.kind == LABEL_NONE
+            || c[2].op != DISM_LABEL || !sameLabel(c[2].label, c[0].label)
+            || labels[findLabel(c[2].label)].refs != 1) continue;
+        // the halting code: straight-line code ending in hlt
+        int n = 0;
+        while (n < MAX_HALT_CODE && i + 3 + n < dismLength && c[3 + n].op != DISM_LABEL
+               && !endsFlow(&c[3 + n]) && !isBranch(&c[3 + n])
+               && c[3 + n].label.kind == LABEL_NONE) n++;
+        if (i + 4 + n >= dismLength || c[3 + n].op != DISM_HLT
+            || c[4 + n].op != DISM_LABEL || !sameLabel(c[4 + n].label, c[1].label)) continue;
+        n++;
+        // share one copy of each different piece of halting code
+        int b;
+        for (b = 0; b < numBlocks; b++) {
+            int same = blockLength[b] == n;
+            for (int j = 0; same && j < n; j++) {
+                DismInstr *x = &blocks[b][j + 1], *y = &c[3 + j];
+                same = x->op == y->op && memcmp(x->reg, y->reg, 3) == 0 && x->imm == y->imm;
+            }
+            if (same) break;
+        }
+        if (b == numBlocks) {
+            if (numBlocks == MAX_HALT_BLOCKS) continue;
+            memcpy(blocks[b], &c[2], sizeof(DismInstr) * (n + 1));
+            blockLength[b] = n;
+            numBlocks++;
+            removed[JUMP_OVER] -= n + 1;
+        } else {
+            DismInstr *branch = &dismCode[kept - 1];
+            dropRef(branch);
+            branch->label = blocks[b][0].label;
+            labels[findLabel(branch->label)].refs++;
+            labels[findLabel(branch->label)].branchRefs++;
+        }
+        for (int j = 1; j < 3 + n; j++) dropInstr(i + j, JUMP_OVER);
+        hits[JUMP_OVER]++;
+        i += 2 + n;
+    }
+    // the code left out is longer than the code added back
+    for (int b = 0; b < numBlocks; b++) {
+        memcpy(&dismCode[kept], blocks[b], sizeof(DismInstr) * (blockLength[b] + 1));
+        kept += blockLength[b] + 1;
+    }
+    dismLength = kept;
+}
+
+// a state that knows only r0 (always 0)
+static RegState unknownRegs(void) {
+    RegState s;
+    memset(&s, 0, sizeof s);
+    s.reachable = 1;
+    s.known = 1;
+    return s;
+}
+
+// what is known both in *into and in from
+static void meet(RegState *into, const RegState *from) {
+    if (!from->reachable) return;
+    if (!into->reachable) {
+        *into = *from;
+        return;
+    }
+    for (int r = 1; r < 8; r++)
+        if (into->value[r] != from->value[r]) into->known &= ~(1u << r);
+    into->known &= from->known;
+}
+
+// PEEP_CONSTANTS: follow the registers' known values forward through
+// the program; at a label, they are what every branch to it and the
+// code falling into it agree on, if all of those come before it
+static void constants(void) {
+    RegState *states = calloc(numLabels + 1, sizeof(RegState));
+    if (states == NULL) {
+        printf("ERROR: calloc failed in the peephole optimizer\n");
+        exit(-1);
+    }
+    RegState s = unknownRegs();
+    int kept = 0;
+    for (int i = 0; i < dismLength; i++) {
+        DismInstr *instr = &dismCode[i];
+        if (instr->op == DISM_MOV && instr->label.kind == LABEL_NONE
+            && (s.known >> instr->reg[0] & 1) && s.value[instr->reg[0]] == instr->imm
+            && s.reachable) {
+            dropInstr(i, CONSTANTS);
+            hits[CONSTANTS]++;
+            continue;
+        }
+        dismCode[kept++] = *instr;
+        if (instr->op == DISM_LABEL) {
+            int l = findLabel(instr->label);
+            if (labels[l].addressTaken || labels[l].seenBranches < labels[l].branchRefs)
+                s = unknownRegs();
+            else {
+                meet(&states[l], &s);
+                s = states[l];
+            }
+            continue;
+        }
+        if (!s.reachable) s = unknownRegs();
+        if (instr->op == DISM_MOV && instr->label.kind == LABEL_NONE) {
+            int r = instr->reg[0];
+            if (r != 0) {
+                s.known |= 1u << r;
+                s.value[r] = instr->imm;
+            }
+            continue;
+        }
+        for (int r = 1; r < 8; r++)
+            if (writesReg(instr, r)) s.known &= ~(1u << r);
+        if (instr->label.kind != LABEL_NONE && isBranch(instr)) {
+            int l = findLabel(instr->label);
+            labels[l].seenBranches++;
+            meet(&states[l], &s);
+        }
+        if (endsFlow(instr)) s.reachable = 0;
+    }
+    free(states);
+    dismLength = kept;
+}
+
+// PEEP_LABELS: see peephole.h
+static void foldLabels(void) {
+    int kept = 0;
+    for (int i = 0; i < dismLength; i++) {
+        DismInstr *instr = &dismCode[i];
+        if (instr->op == DISM_LABEL && instr->label.kind != LABEL_METHOD
+            && labels[findLabel(instr->label)].refs == 0) {
+            dropInstr(i, LABELS);
+            hits[LABELS]++;
+            continue;
+        }
+        if (instr->op != DISM_LABEL && kept > 0 && dismCode[kept - 1].op == DISM_LABEL) {
+            dismCode[kept - 1].imm = 1;
+            removed[LABELS]++;
+            hits[LABELS]++;
+        }
+        dismCode[kept++] = *instr;
+    }
+    dismLength = kept;
+}
+
+// the patterns in the order they are applied
+static const struct {
+    unsigned int pattern;
+    const char *name;
+    void (*run)(void);
+} passOrder[NUM_PATTERNS] = {
+    { PEEP_PUSH_POP, "push-pop", pushPop },
+    { PEEP_JUMP_OVER, "jump-over", jumpOver },
+    { PEEP_CONSTANTS, "constants", constants },
+    { PEEP_LABELS, "labels", foldLabels }
+};
+
+void optimizeDism(void) {
+    unsigned int patterns = enabledPatterns;
+    if (patterns == 0 || dismLength == 0) return;
+    memset(hits, 0, sizeof hits);
+    memset(removed, 0, sizeof removed);
+    beginPhase("find labels");
+    findLabels();
+    endPhase();
+    for (int p = 0; p < NUM_PATTERNS; p++) {
+        if (!(patterns & passOrder[p].pattern)) continue;
+        beginPhase(passOrder[p].name);
+        passOrder[p].run();
+        endPhase();
+    }
+    free(labels);
+    free(labelIndex);
+    labels = NULL;
+    labelIndex = NULL;
+    pthread_mutex_lock(&statsLock);
+    for (int p = 0; p < NUM_PATTERNS; p++) {
+        totalHits[p] += hits[p];
+        totalRemoved[p] += removed[p];
+    }
+    pthread_mutex_unlock(&statsLock);
+}
+
+void printPeepholeStats(FILE *out) {
+    pthread_mutex_lock(&statsLock);
+    fprintf(out, "Peephole patterns:\n");
+    fprintf(out, "  %-10s %10s %10s\n", "pattern", "hits", "removed");
+    for (int p = 0; p < NUM_PATTERNS; p++)
+        if (enabledPatterns & (1u << p))
+            fprintf(out, "  %-10s %10lu %10lu\n", patternNames[p], totalHits[p], totalRemoved[p]);
+    pthread_mutex_unlock(&statsLock);
+}
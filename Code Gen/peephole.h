@@ -0,0 +1,44 @@
+/* File peephole.h: Peephole optimizer for the DJ compiler's DISM code */
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <stdio.h>
+
+/* The patterns optimizeDism() can apply, as bits of a mask:
+   PEEP_PUSH_POP   a push (str 6 0 r and SP--) straight away popped
+                   again (SP++) is just the store
+   PEEP_CONSTANTS  a "mov r n" is dropped when r is known to hold n
+                   already, as r1 is before most SP adjustments
+   PEEP_JUMP_OVER  "beq/blt a b #A; jmp 0 #B; #A: ...; hlt r; #B:"
+                   becomes "beq/blt a b #H", where #H is one copy of the
+                   halting code, moved after the rest of the program
+   PEEP_LABELS     labels nothing refers to are dropped (but for method
+                   labels), and the rest are put on the instruction after
+                   them instead of on a "mov 0 0" of their own */
+#define PEEP_PUSH_POP  0x1
+#define PEEP_CONSTANTS 0x2
+#define PEEP_JUMP_OVER 0x4
+#define PEEP_LABELS    0x8
+#define PEEP_ALL       0xF
+
+/* Apply only the patterns in mask patterns from now on (the default is
+   PEEP_ALL; 0 turns the optimizer off).  The setting belongs to the
+   calling thread, so threads in one process may use different
+   patterns; compileBatch() (see compile.h) gives its threads its
+   caller's. */
+void usePeepholes(unsigned int patterns);
+
+/* Returns the mask of patterns this thread applies */
+unsigned int peepholesInUse(void);
+
+/* Apply the chosen patterns to this thread's DISM program (see dism.h),
+   as generateDISM() does before writing it out */
+void optimizeDism(void);
+
+/* Print how often each pattern has applied and how many instructions
+   it removed, over every program optimized so far on any thread, to
+   out */
+void printPeepholeStats(FILE *out);
+
+#endif
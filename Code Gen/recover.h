@@ -0,0 +1,25 @@
+/* File recover.h: Recovering from errors in the DJ program */
+
+#ifndef RECOVER_H
+#define RECOVER_H
+
+/* Every phase reports an error in the program being compiled (lex,
+   syntax, AST, symbol-table, type and code-generation errors) by
+   printing its message and then calling compileFailed().
+   Normally that just exits with the given status, as the compiler
+   always has.  Inside tryCompile(), though, compileFailed() unwinds
+   back to tryCompile() instead, so a long-running process (see
+   serveCompiles() in compile.h) survives a bad program.
+   Recovery points are per thread. */
+
+/* Report that compilation cannot go on (the message has already been
+   printed).  Does not return. */
+_Noreturn void compileFailed(int status);
+
+/* Run phase(arg), recovering from any compileFailed() it calls.
+   Returns 0 if phase returned normally and nonzero if it failed.
+   After a failure the caller must reset whatever state the phase
+   left behind (see compileFile() in compile.c). */
+int tryCompile(void (*phase)(void *arg), void *arg);
+
+#endif
@@ -1,117 +1,268 @@
-/* File symtbl.h: Enhanced symbol-table data structures for DJ */
-
-#ifndef SYMTBL_H
-#define SYMTBL_H
-
-#include "ast.h"
-
-/* METHOD TO SET UP GLOBALS (INCLUDING SYMBOL TABLES) */
-/* Using the parameter AST representing the whole program, allocate
-   and build the global symbol-table data.
-
-   NOTE on typing conventions:
-   This compiler represents types as integers.
-   The DJ type denoted by int i is:
-     The ith class declared in the source program, if i > 0
-     Object, if i = 0
-     nat, if i = -1
-     "any-object" (i.e., the type of "null"), if i = -2
-     "no-type" (i.e., an illegal type, or Object's superclass), if i = -3
-   When i>=0, the symbol table for type (i.e., class) i is
-   at classesST[i].
-
-   NOTE on typechecking:
-   This method does NOT perform any checks on the symbol tables
-   it builds, although the entry for the Object class
-   (in classesST[0]) will of course be free of errors.
-   E.g., variable/method/class names may appear multiple times
-   in the tables, and types may be invalid.
-   If the DJ program declares a variable of an undefined type,
-   that type will appear as -3 in the symbol table. */
-void setupSymbolTables(ASTree *fullProgramAST);
-
-/* HELPER METHOD TO CONVERT CLASS NAMES TO NUMBERS */
-/* Returns the number for a given class name.
-   Returns: 0 for Object,
-     1 for first class declared in program,
-     2 for 2nd class declared in program, etc.,
-     and -3 for a nonexistent class name.
-   Determines number for the given class using the global 
-   variable wholeProgram (defined below).  */
-int classNameToNumber(char *className);
-
-/* TYPEDEFS FOR ENHANCED SYMBOL TABLES */
-/* Encapsulate all information relevant to a DJ variable:
-   the variable name, source-program line number on which the variable is
-   declared, variable type, and line number on which the type appears. */
-typedef struct vdecls {
-  char *varName;
-  int varNameLineNumber;
-  int type;
-  int typeLineNumber;
-} VarDecl;
-
-/* Encapsulate all information relevant to a DJ method:
-   the method name, return type, parameter name, parameter type, 
-   flag to indicate whether the method is declared "final",
-   local variables, and method body. */
-typedef struct mdecls {
-  char *methodName;
-  int methodNameLineNumber;
-  int returnType;
-  int returnTypeLineNumber;
-  char *paramName;
-  int paramNameLineNumber;
-  int paramType;
-  int paramTypeLineNumber;
-  int isFinal;
-
-  //An array of this method's local variables
-  int numLocals; //size of the array
-  VarDecl *localST; //the array itself
-
-  //The method's executable body
-  ASTree *bodyExprs; 
-} MethodDecl;
-
-/* Encapsulate all information relevant to a DJ class:
-   the class name, superclass, flag to indicate whether the class is "final",
-   and arrays of information about the class's variables and methods. */
-typedef struct classinfo {
-  char *className;
-  int classNameLineNumber;
-  int superclass;
-  int superclassLineNumber;
-  int isFinal;
-
-  //array of variable information--the ith element of 
-  //the array encapsulates information about the ith
-  //variable field in this class
-  int numVars;  //size of the array
-  VarDecl *varList; //the array itself
-
-  //array of method information--the ith element of the array
-  //encapsulates information about the ith method in this class
-  int numMethods;  //size of the array
-  MethodDecl *methodList; //the array itself
-} ClassDecl;
-
-/* GLOBALS THAT PROVIDE EASY ACCESS TO PARTS OF THE AST */
-/* THESE GLOBALS GET SET IN setupSymbolTables */
-// The entire program's AST 
-extern ASTree *wholeProgram;
-     
-// The expression list in the main block of the DJ program
-extern ASTree *mainExprs; 
-
-// Array (symbol table) of locals in the main block
-extern int numMainBlockLocals;  //size of the array
-extern VarDecl *mainBlockST;  //the array itself
-   
-// Array (symbol table) of class declarations
-// Note that the minimum array size is 1,
-//   due to the always-present Object class
-extern int numClasses;  //size of the array
-extern ClassDecl *classesST;  //the array itself
-
-#endif
+/* File symtbl.h: Enhanced symbol-table data structures for DJ */
+
+#ifndef SYMTBL_H
+#define SYMTBL_H
+
+#include "ast.h"
+
+/* METHOD TO SET UP GLOBALS (INCLUDING SYMBOL TABLES) */
+/* Using the parameter AST representing the whole program, allocate
+   and build the global symbol-table data.
+
+   NOTE on typing conventions:
+   This compiler represents types as integers.
+   The DJ type denoted by int i is:
+     The ith class declared in the source program, if i > 0
+     Object, if i = 0
+     nat, if i = -1
+     "any-object" (i.e., the type of "null"), if i = -2
+     "no-type" (i.e., an illegal type, or Object's superclass), if i = -3
+   When i>=0, the symbol table for type (i.e., class) i is
+   at classesST[i].
+
+   NOTE on typechecking:
+   This method does NOT perform any checks on the symbol tables
+   it builds, although the entry for the Object class
+   (in classesST[0]) will of course be free of errors.
+   E.g., variable/method/class names may appear multiple times
+   in the tables, and types may be invalid.
+   If the DJ program declares a variable of an undefined type,
+   that type will appear as -3 in the symbol table. */
+void setupSymbolTables(ASTree *fullProgramAST);
+
+/* Free all the tables built by setupSymbolTables() at once (they live
+   in symtblArena, see arena.h) and reset the globals below. */
+void releaseSymbolTables();
+
+/* HELPER METHOD TO CONVERT CLASS NAMES TO NUMBERS */
+/* Returns the number for a given class name.
+   Returns: 0 for Object,
+     1 for first class declared in program,
+     2 for 2nd class declared in program, etc.,
+     and -3 for a nonexistent class name.
+   Determines number for the given class using the global 
+   variable wholeProgram (defined below).  */
+int classNameToNumber(char *className);
+
+/* Same as classNameToNumber, but for a class name that has already been
+   interned (see intern.h) as number nameNum. */
+int classNumberOf(int nameNum);
+
+/* HASH INDEXES OF NAMES */
+/* An index maps the interned numbers (see intern.h) of the names in one
+   of the arrays below to their positions in the array, using a hash
+   table with open addressing.  All indexes are built once, in
+   setupSymbolTables(), so each lookup takes expected constant time
+   however large the program is. */
+typedef struct {
+  unsigned int mask;  /* number of slots - 1; the count is a power of 2 */
+  int *slots;         /* pairs (name number, position); name -1 = empty */
+} NameIndex;
+
+/* Returns the position of the name nameNum in the array index covers,
+   or -1 if it is not there.  When a name occurs more than once (an
+   error the typechecker reports), its first position is returned. */
+int indexLookup(const NameIndex *index, int nameNum);
+
+/* TYPEDEFS FOR ENHANCED SYMBOL TABLES */
+/* Encapsulate all information relevant to a DJ variable:
+   the variable name, source-program line number on which the variable is
+   declared, variable type, and line number on which the type appears.
+   Each name is kept both as text (for messages) and as its interned
+   number (for comparisons); the same holds for the structs below. */
+typedef struct vdecls {
+  char *varName;
+  int varNameNum;
+  int varNameLineNumber;
+  int type;
+  int typeLineNumber;
+} VarDecl;
+
+/* Encapsulate all information relevant to a DJ method:
+   the method name, return type, parameter name, parameter type, 
+   flag to indicate whether the method is declared "final",
+   local variables, and method body. */
+typedef struct mdecls {
+  char *methodName;
+  int methodNameNum;
+  int methodNameLineNumber;
+  int returnType;
+  int returnTypeLineNumber;
+  char *paramName;
+  int paramNameNum;
+  int paramNameLineNumber;
+  int paramType;
+  int paramTypeLineNumber;
+  int isFinal;
+  int slot; //this method's slot in its class's slots table (see below)
+
+  //An array of this method's local variables
+  int numLocals; //size of the array
+  VarDecl *localST; //the array itself
+  NameIndex localIndex; //index of localST by name
+
+  //The method's executable body
+  ASTree *bodyExprs; 
+} MethodDecl;
+
+/* One entry of a class's method-resolution table: the method that
+   objects of the class run for the entry's slot */
+typedef struct {
+  int classNum;   //class declaring the method
+  int methodNum;  //its index in that class's methodList
+  int overridden; //nonzero if some subclass runs another method for it
+} MethodSlot;
+
+/* Encapsulate all information relevant to a DJ class:
+   the class name, superclass, flag to indicate whether the class is "final",
+   and arrays of information about the class's variables and methods. */
+typedef struct classinfo {
+  char *className;
+  int classNameNum;
+  int classNameLineNumber;
+  int superclass;
+  int superclassLineNumber;
+  int isFinal;
+
+  //array of variable information--the ith element of 
+  //the array encapsulates information about the ith
+  //variable field in this class
+  int numVars;  //size of the array
+  VarDecl *varList; //the array itself
+  NameIndex varIndex; //index of varList by name
+
+  //flattened layout of this class's objects: objectSize words, the
+  //header (the object's class number) at offset OBJECT_HEADER and the
+  //fields after it, inherited ones first, so every field has the same
+  //offset in all subclasses.  fieldOffsets[i] is varList[i]'s offset.
+  int objectSize;
+  int *fieldOffsets;
+
+  //method-resolution table, by slot, of every method this class's
+  //objects have (declared or inherited).  It starts with a copy of the
+  //superclass's table, so a method keeps its slot number in every
+  //subclass; an overriding method takes over the slot of the method it
+  //overrides, and any other method gets a new slot at the end.
+  int numSlots;
+  MethodSlot *slots;
+
+  //place in the inheritance tree, numbered once in setupSymbolTables:
+  //a preorder walk of the tree numbers this class preorder and its
+  //subclasses preorder+1 .. lastDescendant.  depth is the number of
+  //superclasses up to the tree's root (Object, for a legal program),
+  //and ancestors[k] is the 2^k-th superclass (the root, if there is no
+  //such superclass).  Classes on or below an inheritance cycle are in
+  //no tree; they get depth -1 and preorder -1.
+  int preorder;
+  int lastDescendant;
+  int depth;
+  int *ancestors;
+
+  //array of method information--the ith element of the array
+  //encapsulates information about the ith method in this class
+  int numMethods;  //size of the array
+  MethodDecl *methodList; //the array itself
+  NameIndex methodIndex; //index of methodList by name
+} ClassDecl;
+
+/* Offset of the header word in every object (see objectSize above) */
+#define OBJECT_HEADER 0
+
+/* Returns the declaration of the field named nameNum that objects of
+   class cls have (declared in cls or inherited), or NULL if none.
+   If declaringClass is not NULL, the number of the class declaring the
+   field is stored there. */
+VarDecl *findField(int cls, int nameNum, int *declaringClass);
+
+/* Same as findField, for methods */
+MethodDecl *findMethod(int cls, int nameNum, int *declaringClass);
+
+/* STACK FRAMES
+   A call pushes, in order, the return label, the calling object ("this"),
+   the call's static class number, the method's slot number, and the
+   argument.  The method's prologue then pushes the caller's frame
+   pointer (FP) and points FP at it, pushes the method's locals, and
+   pushes the caller's stack limit (see STACK_LIMIT below).
+   So relative to FP a method finds: */
+#define FRAME_PARAM 1    /* its parameter */
+#define FRAME_THIS 4     /* the calling object */
+#define FRAME_RETURN 5   /* the return label (replaced by the result) */
+/* and its ith local at offset FRAME_LOCALS - i, and the caller's stack
+   limit just after its last local.  The main block has no caller; its
+   ith local is at offset -i from FP. */
+#define FRAME_LOCALS (-1)
+
+/* Memory address of the stack limit: the lowest SP that any method or
+   main block still running may push down to.  Each prologue lowers it
+   to its own lowest SP if that is lower, and each method's epilogue
+   puts back the caller's.  new keeps the heap below it, so an object
+   allocated by a callee cannot lie where a caller will push later.
+   (The heap starts at address 1, so address 0 is free.) */
+#define STACK_LIMIT 0
+
+/* Resolve every variable name used in the program's expressions once,
+   setting varKind, varOffset and the statics (see ast.h) of each ID and
+   ID = E node and of the AST_ID naming its variable.  A name resolves
+   as in DJ's scoping: in the main block to a main-block local; in a
+   method to its parameter, else one of its locals, else a field of the
+   class (declared or inherited).  Names with no declaration are left
+   VAR_UNRESOLVED for the typechecker to report.
+   setupSymbolTables() calls this when the tables are complete. */
+void resolveNames();
+
+/* Returns nonzero iff class sub is class super or one of its direct or
+   indirect subclasses.  Takes constant time (see preorder above). */
+int isSubclass(int sub, int super);
+
+/* Returns the deepest class that classes c1 and c2 are both subclasses
+   of, or -3 if there is none (i.e., they are in different trees, or on
+   an inheritance cycle).  Takes time logarithmic in the classes' depth. */
+int commonSuperclass(int c1, int c2);
+
+/* GLOBALS THAT PROVIDE EASY ACCESS TO PARTS OF THE AST */
+/* THESE GLOBALS GET SET IN setupSymbolTables */
+/* They are thread-local, so separate threads can each compile their own
+   program at the same time. */
+// The entire program's AST 
+extern _Thread_local ASTree *wholeProgram;
+     
+// The expression list in the main block of the DJ program
+extern _Thread_local ASTree *mainExprs; 
+
+// Array (symbol table) of locals in the main block
+extern _Thread_local int numMainBlockLocals;  //size of the array
+extern _Thread_local VarDecl *mainBlockST;  //the array itself
+extern _Thread_local NameIndex mainBlockIndex;  //index of it by name
+   
+// Array (symbol table) of class declarations
+// Note that the minimum array size is 1,
+//   due to the always-present Object class
+extern _Thread_local int numClasses;  //size of the array
+extern _Thread_local ClassDecl *classesST;  //the array itself
+
+/* SHARING THE TABLES WITH OTHER THREADS */
+/* Every thread-local variable behind the globals above (and the
+   lookups declared in this file), gathered so that another thread can
+   read the same tables. */
+typedef struct {
+  ASTree *wholeProgram;
+  ASTree *mainExprs;
+  int numMainBlockLocals;
+  VarDecl *mainBlockST;
+  NameIndex mainBlockIndex;
+  int numClasses;
+  ClassDecl *classesST;
+  int objectNameNum;
+  NameIndex classIndex;
+  int ancestorLevels;
+} SymbolTables;
+
+/* Store this thread's tables in tables */
+void saveSymbolTables(SymbolTables *tables);
+
+/* Have this thread read the tables saved in tables by another thread.
+   They stay in the saving thread's symtblArena, so that thread must not
+   release them until this thread is done with them. */
+void useSymbolTables(const SymbolTables *tables);
+
+#endif
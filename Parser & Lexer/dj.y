@@ -1,149 +1,181 @@
-/* DJ PARSER */
-%code provides {
-  #include "lex.yy.c"
- 
-  /* Function for printing generic syntax-error messages */
-  void yyerror(const char *str) {
-    printf("Syntax error on line %d at token %s\n", yylineno, yytext);
-    printf("(This version of the compiler exits after finding the first ");
-    printf("syntax error.)\n");
-    exit(-1);
-  }
-}
-
-%token FINAL CLASS ID EXTENDS MAIN NATTYPE 
-%token NATLITERAL PRINTNAT READNAT PLUS MINUS TIMES EQUALITY LESS
-%token ASSERT OR NOT IF ELSE WHILE
-%token ASSIGN NUL NEW THIS DOT 
-%token SEMICOLON LBRACE RBRACE LPAREN RPAREN
-%token ENDOFFILE
-
-%start pgm
-
-%right ASSERT
-%right ASSIGN
-%nonassoc LESS
-%nonassoc EQUALITY 
-%right NOT 
-%left OR
-%left PLUS MINUS
-%left TIMES
-%left DOT
-
-%%
-
-pgm:
-    class_declarations main_block ENDOFFILE
-    {return 0;}
-    ;
-
-class_declarations:
-    /* empty */
-    | class_declarations class_declaration
-    ;
-
-class_declaration:
-    final_class_declaration
-    | nonfinal_class_declaration
-    ;
-
-final_class_declaration:
-    FINAL CLASS ID EXTENDS ID LBRACE var_declarations method_decl_check RBRACE
-    ;
-
-nonfinal_class_declaration:
-    CLASS ID EXTENDS ID LBRACE var_declarations method_decl_check RBRACE
-    ;
-
-var_declarations:
-    /* empty */
-    | var_declarations var_declaration
-    ;
-
-var_declaration:
-    type ID SEMICOLON
-    ;
-
-type:
-    NATTYPE
-    | ID
-    ;
-
-method_decl_list:
-    method_declaration
-    | method_decl_list method_declaration
-    ;
-
-/* This checks if a class has at least one method declaration */
-method_decl_check:
-    /* empty */ 
-    | method_decl_list
-    ;
-
-method_declaration:
-    final_method_declaration
-    | nonfinal_method_declaration
-    ;
-
-final_method_declaration:
-    FINAL type ID LPAREN type ID RPAREN var_expr_block
-    ;
-
-nonfinal_method_declaration:
-    type ID LPAREN type ID RPAREN var_expr_block
-    ;
-
-var_expr_block:
-    LBRACE var_declarations expr_list RBRACE
-    ;
-
-main_block:
-    MAIN var_expr_block
-    ;
-
-expr_list:
-    expr SEMICOLON
-    | expr_list expr SEMICOLON
-    ;
-
-expr:
-    expr PLUS expr
-    | expr MINUS expr
-    | expr TIMES expr
-    | expr EQUALITY expr
-    | expr LESS expr
-    | ASSERT expr
-    | NOT expr
-    | expr OR expr
-    | NATLITERAL
-    | NUL
-    | IF LPAREN expr RPAREN LBRACE expr_list RBRACE ELSE LBRACE expr_list RBRACE
-    | WHILE LPAREN expr RPAREN LBRACE expr_list RBRACE
-    | NEW ID LPAREN RPAREN
-    | THIS
-    | PRINTNAT LPAREN expr RPAREN
-    | READNAT LPAREN RPAREN
-    | ID
-    | expr DOT ID
-    | ID ASSIGN expr
-    | expr DOT ID ASSIGN expr
-    | ID LPAREN expr RPAREN
-    | expr DOT ID LPAREN expr RPAREN
-    | LPAREN expr RPAREN
-    ;
-
-%%
-
-int main(int argc, char **argv) {
-  if (argc != 2) {
-    printf("Usage: parsedj filename\n");
-    exit(-1);
-  }
-  yyin = fopen(argv[1], "r");
-  if (yyin == NULL) {
-    printf("ERROR: could not open file %s\n", argv[1]);
-    exit(-1);
-  }
-  /* parse the input program */
-  return yyparse();
+/* DJ PARSER */
+%code provides {
+  /* -DHANDSCAN selects the hand-written scanner over the flex one */
+  #ifdef HANDSCAN
+  #include "djscan.c"
+  #else
+  #include "lex.yy.c"
+  #endif
+ 
+  /* Function for printing generic syntax-error messages */
+  void yyerror(const char *str) {
+    printf("Syntax error on line %d at token %s\n", yylineno, yytext);
+    printf("(This version of the compiler exits after finding the first ");
+    printf("syntax error.)\n");
+    exit(-1);
+  }
+}
+
+%token FINAL CLASS ID EXTENDS MAIN NATTYPE 
+%token NATLITERAL PRINTNAT READNAT PLUS MINUS TIMES EQUALITY LESS
+%token ASSERT OR NOT IF ELSE WHILE
+%token ASSIGN NUL NEW THIS DOT 
+%token SEMICOLON LBRACE RBRACE LPAREN RPAREN
+%token ENDOFFILE
+
+%start pgm
+
+%right ASSERT
+%right ASSIGN
+%nonassoc LESS
+%nonassoc EQUALITY 
+%right NOT 
+%left OR
+%left PLUS MINUS
+%left TIMES
+%left DOT
+
+%%
+
+pgm:
+    class_declarations main_block ENDOFFILE
+    {return 0;}
+    ;
+
+class_declarations:
+    /* empty */
+    | class_declarations class_declaration
+    ;
+
+class_declaration:
+    final_class_declaration
+    | nonfinal_class_declaration
+    ;
+
+final_class_declaration:
+    FINAL CLASS ID EXTENDS ID LBRACE var_declarations method_decl_check RBRACE
+    ;
+
+nonfinal_class_declaration:
+    CLASS ID EXTENDS ID LBRACE var_declarations method_decl_check RBRACE
+    ;
+
+var_declarations:
+    /* empty */
+    | var_declarations var_declaration
+    ;
+
+var_declaration:
+    type ID SEMICOLON
+    ;
+
+type:
+    NATTYPE
+    | ID
+    ;
+
+method_decl_list:
+    method_declaration
+    | method_decl_list method_declaration
+    ;
+
+/* This checks if a class has at least one method declaration */
+method_decl_check:
+    /* empty */ 
+    | method_decl_list
+    ;
+
+method_declaration:
+    final_method_declaration
+    | nonfinal_method_declaration
+    ;
+
+final_method_declaration:
+    FINAL type ID LPAREN type ID RPAREN var_expr_block
+    ;
+
+nonfinal_method_declaration:
+    type ID LPAREN type ID RPAREN var_expr_block
+    ;
+
+var_expr_block:
+    LBRACE var_declarations expr_list RBRACE
+    ;
+
+main_block:
+    MAIN var_expr_block
+    ;
+
+expr_list:
+    expr SEMICOLON
+    | expr_list expr SEMICOLON
+    ;
+
+expr:
+    expr PLUS expr
+    | expr MINUS expr
+    | expr TIMES expr
+    | expr EQUALITY expr
+    | expr LESS expr
+    | ASSERT expr
+    | NOT expr
+    | expr OR expr
+    | NATLITERAL
+    | NUL
+    | IF LPAREN expr RPAREN LBRACE expr_list RBRACE ELSE LBRACE expr_list RBRACE
+    | WHILE LPAREN expr RPAREN LBRACE expr_list RBRACE
+    | NEW ID LPAREN RPAREN
+    | THIS
+    | PRINTNAT LPAREN expr RPAREN
+    | READNAT LPAREN RPAREN
+    | ID
+    | expr DOT ID
+    | ID ASSIGN expr
+    | expr DOT ID ASSIGN expr
+    | ID LPAREN expr RPAREN
+    | expr DOT ID LPAREN expr RPAREN
+    | LPAREN expr RPAREN
+    ;
+
+%%
+
+int main(int argc, char **argv) {
+  /* Options:
+     -mmap           scan a memory mapping of the whole file, not yyin
+     -lexthreads N   (hand-written scanner only) lex the whole file on
+                     N threads before parsing starts */
+  int useMmap = 0;
+  int lexThreads = 0;
+  int arg = 1;
+  while (arg < argc - 1 && argv[arg][0] == '-') {
+    if (strcmp(argv[arg], "-mmap") == 0) useMmap = 1;
+    else if (strcmp(argv[arg], "-lexthreads") == 0 && arg + 1 < argc - 1)
+      lexThreads = atoi(argv[++arg]);
+    else break;
+    arg++;
+  }
+  if (arg != argc - 1) {
+    printf("Usage: parsedj [-mmap] [-lexthreads N] filename\n");
+    exit(-1);
+  }
+  char *filename = argv[arg];
+  if (useMmap) {
+    if (!mapSourceFile(filename)) {
+      printf("ERROR: could not open file %s\n", filename);
+      exit(-1);
+    }
+  } else {
+    yyin = fopen(filename, "r");
+    if (yyin == NULL) {
+      printf("ERROR: could not open file %s\n", filename);
+      exit(-1);
+    }
+  }
+  #ifdef HANDSCAN
+  if (lexThreads > 0) lexInParallel(lexThreads);
+  #else
+  if (lexThreads > 0) printf("(-lexthreads needs the hand-written scanner; lexing serially)\n");
+  #endif
+  /* parse the input program */
+  return yyparse();
 }
\ No newline at end of file
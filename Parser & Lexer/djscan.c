@@ -0,0 +1,500 @@
+/* Hand-written LEXER for DJ
+   A drop-in alternative to the flex scanner generated from dj.l.
+   Build with -DHANDSCAN to have dj.y include this file instead of
+   lex.yy.c.  It provides the same interface the parser uses from flex
+   (yylex, yytext, yyleng, yylineno, yyin) plus mapSourceFile(), and
+   returns exactly the same Token values as dj.l.
+
+   Keywords are recognized with a compile-time perfect hash instead of
+   one rule per keyword, and identifier and digit runs are scanned eight
+   bytes at a time.
+
+   lexInParallel() can also lex the whole source up front on several
+   threads; yylex() then just hands out the resulting tokens. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#define DEBUG 0
+/* bytes of zero padding after the source, so eight-byte loads near the
+   end of the input never leave the buffer */
+#define SCAN_PAD 8
+/* returned by scanNext() for a character that starts no token */
+#define LEXERROR -2
+
+typedef int Token;
+Token scanned(Token t);
+
+/* Like flex, the including file may redefine yylex's signature (e.g. for
+   a pure parser) by defining YY_DECL first. */
+#ifndef YY_DECL
+#define YY_DECL int yylex(void)
+#endif
+/* ... and how a lex error ends the compile, as with dj.l */
+#ifndef LEX_FAIL
+#define LEX_FAIL(status) exit(status)
+#endif
+
+/* All scanner state is thread-local, so separate threads can each scan
+   (and parse) their own file at the same time. */
+_Thread_local FILE *yyin = NULL;
+_Thread_local char *yytext = "";
+_Thread_local int yyleng = 0;
+_Thread_local int yylineno = 1;
+
+/* Scanner position within a source buffer */
+typedef struct {
+  char *pos;  /* next unscanned character */
+  char *end;  /* one past the last source character */
+  int line;   /* line number of pos */
+} ScanState;
+
+static _Thread_local ScanState source = { NULL, NULL, 1 };
+/* first character of the source buffer */
+static _Thread_local char *sourceStart = NULL;
+/* length of the mapping holding the source, or 0 if it was malloc'd */
+static _Thread_local size_t sourceMapLength = 0;
+/* character overwritten by the NUL that terminates yytext */
+static _Thread_local char heldChar = '\0';
+
+/* PERFECT HASH FOR KEYWORDS */
+/* (first char + 2 * last char + length) mod 32 is distinct for every
+   DJ keyword, so one probe and one memcmp decide keyword vs. ID. */
+#define KEYWORD_HASH(s, len) \
+  (((unsigned char)(s)[0] + 2 * (unsigned char)(s)[(len) - 1] + (len)) & 31)
+
+static const struct { const char *text; Token token; } keywords[32] = {
+  { "printNat", PRINTNAT }, /*  0 */
+  { "readNat", READNAT },   /*  1 */
+  { NULL, 0 },              /*  2 */
+  { "final", FINAL },       /*  3 */
+  { NULL, 0 },              /*  4 */
+  { NULL, 0 },              /*  5 */
+  { "while", WHILE },       /*  6 */
+  { NULL, 0 },              /*  7 */
+  { NULL, 0 },              /*  8 */
+  { NULL, 0 },              /*  9 */
+  { "null", NUL },          /* 10 */
+  { NULL, 0 },              /* 11 */
+  { NULL, 0 },              /* 12 */
+  { "main", MAIN },         /* 13 */
+  { "class", CLASS },       /* 14 */
+  { "assert", ASSERT },     /* 15 */
+  { NULL, 0 },              /* 16 */
+  { NULL, 0 },              /* 17 */
+  { "extends", EXTENDS },   /* 18 */
+  { "else", ELSE },         /* 19 */
+  { NULL, 0 },              /* 20 */
+  { NULL, 0 },              /* 21 */
+  { NULL, 0 },              /* 22 */
+  { "if", IF },             /* 23 */
+  { NULL, 0 },              /* 24 */
+  { "nat", NATTYPE },       /* 25 */
+  { NULL, 0 },              /* 26 */
+  { NULL, 0 },              /* 27 */
+  { NULL, 0 },              /* 28 */
+  { NULL, 0 },              /* 29 */
+  { "this", THIS },         /* 30 */
+  { "new", NEW },           /* 31 */
+};
+
+/* Returns the keyword token for the len-character word at s, or ID */
+static Token keywordOrID(const char *s, int len) {
+  if (len < 2 || len > 8) return ID;
+  int h = KEYWORD_HASH(s, len);
+  const char *k = keywords[h].text;
+  if (k != NULL && (int)strlen(k) == len && memcmp(k, s, len) == 0)
+    return keywords[h].token;
+  return ID;
+}
+
+/* WORD-AT-A-TIME CHARACTER-CLASS RUNS */
+#define ONES  0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+/* High bit of each byte set iff that (ASCII) byte is in [lo, hi] */
+static inline uint64_t bytesInRange(uint64_t w, unsigned lo, unsigned hi) {
+  uint64_t atLeastLo = w + ONES * (0x80 - lo);
+  uint64_t aboveHi = w + ONES * (0x7f - hi);
+  return atLeastLo & ~aboveHi & HIGHS;
+}
+
+/* High bit of each byte set iff that byte equals c */
+static inline uint64_t bytesEqual(uint64_t w, unsigned c) {
+  uint64_t x = w ^ (ONES * c);
+  return ~(((x & ~HIGHS) + ~HIGHS) | x) & HIGHS;
+}
+
+static inline uint64_t identBytes(uint64_t w) {
+  uint64_t ascii = ~w & HIGHS;
+  w &= ~HIGHS; /* keep the range tests from carrying between bytes */
+  return ascii & (bytesInRange(w, 'a', 'z') | bytesInRange(w, 'A', 'Z') |
+                  bytesInRange(w, '0', '9') | bytesEqual(w, '_'));
+}
+
+static inline uint64_t digitBytes(uint64_t w) {
+  uint64_t ascii = ~w & HIGHS;
+  w &= ~HIGHS;
+  return ascii & bytesInRange(w, '0', '9');
+}
+
+/* Returns the address of the first byte at or after p whose class mask
+   (from identBytes or digitBytes) is clear.  The buffer's zero padding
+   guarantees such a byte exists within reach of the last load. */
+static char *skipRun(char *p, uint64_t (*classify)(uint64_t)) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  for (;;) {
+    uint64_t w;
+    memcpy(&w, p, sizeof w);
+    uint64_t outside = ~classify(w) & HIGHS;
+    if (outside) return p + (__builtin_ctzll(outside) >> 3);
+    p += 8;
+  }
+#else
+  for (;;) {
+    uint64_t w = (unsigned char)*p;
+    if (!classify(w)) return p;
+    p++;
+  }
+#endif
+}
+
+/* Scan the next token from s.  Sets *text and *length to the slice of
+   the buffer the token was read from.  Returns LEXERROR (with a
+   one-character slice) for an illegal character. */
+static Token scanNext(ScanState *s, char **text, int *length) {
+  char *p = s->pos;
+  for (;;) {
+    if (p >= s->end) {
+      s->pos = p;
+      *text = p;
+      *length = 0;
+      return ENDOFFILE;
+    }
+    char c = *p;
+    if (c == '\n') { s->line++; p++; }
+    else if (c == ' ' || c == '\t' || c == '\r') p++;
+    else if (c == '/' && p + 1 < s->end && p[1] == '/') {
+      while (p < s->end && *p != '\n') p++;
+    }
+    else break;
+  }
+
+  char *start = p;
+  char c = *p;
+  Token t;
+  if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+    p = skipRun(p + 1, identBytes);
+    if (p > s->end) p = s->end;
+    t = keywordOrID(start, (int)(p - start));
+  } else if (c >= '0' && c <= '9') {
+    p = skipRun(p + 1, digitBytes);
+    if (p > s->end) p = s->end;
+    t = NATLITERAL;
+  } else {
+    p++;
+    switch (c) {
+      case '+': t = PLUS; break;
+      case '-': t = MINUS; break;
+      case '*': t = TIMES; break;
+      case '<': t = LESS; break;
+      case '!': t = NOT; break;
+      case '.': t = DOT; break;
+      case ';': t = SEMICOLON; break;
+      case '{': t = LBRACE; break;
+      case '}': t = RBRACE; break;
+      case '(': t = LPAREN; break;
+      case ')': t = RPAREN; break;
+      case '=':
+        if (p < s->end && *p == '=') { p++; t = EQUALITY; }
+        else t = ASSIGN;
+        break;
+      case '|':
+        if (p < s->end && *p == '|') { p++; t = OR; }
+        else t = LEXERROR;
+        break;
+      default: t = LEXERROR;
+    }
+  }
+  s->pos = p;
+  *text = start;
+  *length = (int)(p - start);
+  return t;
+}
+
+/* Point the scanner at len source characters starting at buffer, which
+   must be followed by SCAN_PAD writable zero bytes. */
+static void setSource(char *buffer, size_t len) {
+  sourceStart = buffer;
+  source.pos = buffer;
+  source.end = buffer + len;
+  source.line = 1;
+}
+
+/* Read all of yyin into a padded buffer (when not using mapSourceFile) */
+static void readSource(void) {
+  size_t capacity = 65536, len = 0, n;
+  char *buffer = malloc(capacity + SCAN_PAD);
+  if (buffer == NULL) {
+    printf("Lex error: malloc failed reading input\n");
+    exit(-1);
+  }
+  while (yyin != NULL && (n = fread(buffer + len, 1, capacity - len, yyin)) > 0) {
+    len += n;
+    if (len == capacity) {
+      capacity *= 2;
+      buffer = realloc(buffer, capacity + SCAN_PAD);
+      if (buffer == NULL) {
+        printf("Lex error: malloc failed reading input\n");
+        exit(-1);
+      }
+    }
+  }
+  memset(buffer + len, 0, SCAN_PAD);
+  setSource(buffer, len);
+}
+
+/* Memory-mapped source input; see mapSourceFile() in dj.l.
+   Here the anonymous reservation is SCAN_PAD bytes longer than the
+   file, and MAP_PRIVATE lets yytext be NUL-terminated in place. */
+int mapSourceFile(char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return 0;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return 0;
+  }
+  size_t size = (size_t)st.st_size;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t length = ((size + SCAN_PAD + page - 1) / page) * page;
+  char *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return 0;
+  }
+  if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(base, length);
+    close(fd);
+    return 0;
+  }
+  close(fd);
+  setSource(base, size);
+  sourceMapLength = length;
+  return 1;
+}
+
+/* PARALLEL CHUNKED LEXING */
+/* DJ has no string literals and only // line comments, so no token
+   spans a newline and the source can be cut at any newline and each
+   piece lexed on its own. */
+
+/* One token lexed ahead of time (16 bytes) */
+typedef struct {
+  Token token;
+  int line;
+  unsigned int offset;  /* of the token text from sourceStart */
+  unsigned int length;
+} LexedToken;
+
+/* One thread's share of the source and the tokens lexed from it */
+typedef struct {
+  ScanState state;  /* line counts from 1 within the chunk */
+  LexedToken *tokens;
+  int numTokens;
+  int capacity;
+} LexChunk;
+
+/* every token of the program, in order, ending in ENDOFFILE or LEXERROR;
+   NULL unless lexInParallel() has run */
+static _Thread_local LexedToken *lexedTokens = NULL;
+static _Thread_local int numLexed = 0;
+static _Thread_local int nextLexed = 0;
+
+static void lexChunkError(void) {
+  printf("Lex error: malloc failed in lexInParallel()\n");
+  exit(-1);
+}
+
+/* Thread body: lex one chunk into its token array, stopping at its end
+   or at the first illegal character */
+static void *lexChunk(void *arg) {
+  LexChunk *chunk = arg;
+  Token t;
+  do {
+    char *text;
+    int length;
+    t = scanNext(&chunk->state, &text, &length);
+    if (chunk->numTokens == chunk->capacity) {
+      chunk->capacity = chunk->capacity * 2 + 64;
+      chunk->tokens = realloc(chunk->tokens, sizeof(LexedToken) * chunk->capacity);
+      if (chunk->tokens == NULL) lexChunkError();
+    }
+    LexedToken *lt = &chunk->tokens[chunk->numTokens++];
+    lt->token = t;
+    lt->line = chunk->state.line;
+    lt->offset = (unsigned int)(text - sourceStart);
+    lt->length = (unsigned int)length;
+  } while (t != ENDOFFILE && t != LEXERROR);
+  return NULL;
+}
+
+/* Lex the entire source (from mapSourceFile(), or else all of yyin) on
+   numThreads threads, each taking a newline-aligned chunk, and stitch
+   the chunks' tokens in order for yylex() to return.  Line numbers and
+   the first lex error come out exactly as with serial scanning. */
+void lexInParallel(int numThreads) {
+  if (source.pos == NULL) readSource();
+  if (numThreads < 1) numThreads = 1;
+  size_t size = (size_t)(source.end - source.pos);
+  if ((size_t)numThreads > size / 4096 + 1) numThreads = (int)(size / 4096 + 1);
+
+  LexChunk *chunks = calloc(numThreads, sizeof(LexChunk));
+  pthread_t *threads = malloc(sizeof(pthread_t) * numThreads);
+  if (chunks == NULL || threads == NULL) lexChunkError();
+  char *start = source.pos;
+  for (int i = 0; i < numThreads; i++) {
+    char *end = source.end;
+    if (i < numThreads - 1) {
+      end = start + (size_t)(source.end - start) / (numThreads - i);
+      while (end < source.end && *end != '\n') end++;
+      if (end < source.end) end++;  /* the newline belongs to this chunk */
+    }
+    chunks[i].state.pos = start;
+    chunks[i].state.end = end;
+    chunks[i].state.line = 1;
+    chunks[i].capacity = (int)((end - start) / 4) + 64;
+    chunks[i].tokens = malloc(sizeof(LexedToken) * chunks[i].capacity);
+    if (chunks[i].tokens == NULL) lexChunkError();
+    start = end;
+  }
+  for (int i = 1; i < numThreads; i++)
+    if (pthread_create(&threads[i], NULL, lexChunk, &chunks[i]) != 0) {
+      printf("Lex error: could not start lexing thread\n");
+      exit(-1);
+    }
+  lexChunk(&chunks[0]);
+  for (int i = 1; i < numThreads; i++) pthread_join(threads[i], NULL);
+
+  /* stitch: drop each chunk's ENDOFFILE but the last, shift line numbers
+     by the newlines in earlier chunks, and stop after a LEXERROR */
+  int total = 0;
+  for (int i = 0; i < numThreads; i++) total += chunks[i].numTokens;
+  lexedTokens = malloc(sizeof(LexedToken) * total);
+  if (lexedTokens == NULL) lexChunkError();
+  numLexed = 0;
+  int lineBase = 0;
+  for (int i = 0; i < numThreads; i++) {
+    int last = chunks[i].numTokens - 1;
+    Token lastToken = chunks[i].tokens[last].token;
+    int keep = (lastToken == ENDOFFILE && i < numThreads - 1) ? last : last + 1;
+    for (int j = 0; j < keep; j++) {
+      lexedTokens[numLexed] = chunks[i].tokens[j];
+      lexedTokens[numLexed].line += lineBase;
+      numLexed++;
+    }
+    free(chunks[i].tokens);
+    if (lastToken == LEXERROR) break;
+    lineBase += chunks[i].state.line - 1;
+  }
+  free(chunks);
+  free(threads);
+  nextLexed = 0;
+}
+
+YY_DECL {
+  if (source.pos == NULL && lexedTokens == NULL) readSource();
+  /* undo the NUL that terminated the previous yytext */
+  if (yyleng > 0) yytext[yyleng] = heldChar;
+
+  Token t;
+  if (lexedTokens != NULL) {
+    /* keep returning the final token once the array is used up */
+    LexedToken *lt = &lexedTokens[nextLexed];
+    if (nextLexed < numLexed - 1) nextLexed++;
+    t = lt->token;
+    yytext = sourceStart + lt->offset;
+    yyleng = (int)lt->length;
+    yylineno = lt->line;
+  } else {
+    t = scanNext(&source, &yytext, &yyleng);
+    yylineno = source.line;
+  }
+  heldChar = yytext[yyleng];
+  yytext[yyleng] = '\0';
+  if (t == LEXERROR) {
+    if (DEBUG) printf("\n");
+    printf("Lex error on line %d: Illegal character %s\n", yylineno, yytext);
+    LEX_FAIL(-1);
+  }
+  return scanned(t);
+}
+
+/* Release the current source buffer and reset the scanner, so the
+   next yylex() starts on a new input */
+void finishSource(void) {
+  if (sourceStart != NULL) {
+    if (sourceMapLength > 0) munmap(sourceStart, sourceMapLength);
+    else free(sourceStart);
+  }
+  if (yyin != NULL && yyin != stdin) fclose(yyin);
+  free(lexedTokens);
+  yyin = NULL;
+  yytext = "";
+  yyleng = 0;
+  yylineno = 1;
+  source.pos = source.end = NULL;
+  source.line = 1;
+  sourceStart = NULL;
+  sourceMapLength = 0;
+  lexedTokens = NULL;
+  numLexed = nextLexed = 0;
+}
+
+/* process and return scanned token t (prints the same stream as dj.l) */
+Token scanned(Token t) {
+  if (DEBUG == 0) return t;
+  switch (t) {
+    case FINAL: printf("FINAL "); return t;
+    case CLASS: printf("CLASS "); return t;
+    case EXTENDS: printf("EXTENDS "); return t;
+    case MAIN: printf("MAIN "); return t;
+    case NATTYPE: printf("NATTYPE "); return t;
+    case NATLITERAL: printf("NATLITERAL(%s) ", yytext); return t;
+    case PRINTNAT: printf("PRINTNAT "); return t;
+    case READNAT: printf("READNAT "); return t;
+    case PLUS: printf("PLUS "); return t;
+    case MINUS: printf("MINUS "); return t;
+    case TIMES: printf("TIMES "); return t;
+    case EQUALITY: printf("EQUALITY "); return t;
+    case LESS: printf("LESS "); return t;
+    case ASSERT: printf("ASSERT "); return t;
+    case OR: printf("OR "); return t;
+    case NOT: printf("NOT "); return t;
+    case IF: printf("IF "); return t;
+    case ELSE: printf("ELSE "); return t;
+    case WHILE: printf("WHILE "); return t;
+    case ASSIGN: printf("ASSIGN "); return t;
+    case NUL: printf("NUL "); return t;
+    case NEW: printf("NEW "); return t;
+    case THIS: printf("THIS "); return t;
+    case DOT: printf("DOT "); return t;
+    case SEMICOLON: printf("SEMICOLON "); return t;
+    case LBRACE: printf("LBRACE "); return t;
+    case RBRACE: printf("RBRACE "); return t;
+    case LPAREN: printf("LPAREN "); return t;
+    case RPAREN: printf("RPAREN "); return t;
+    case ID: printf("ID(%s) ", yytext); return t;
+    case ENDOFFILE: printf("ENDOFFILE\n"); return t;
+    default: printf("ERROR: invalid token in scanned().\n"); LEX_FAIL(-1);
+  }
+}
@@ -0,0 +1,938 @@
+/* File benchdj.c: benchmarks of the compiler on generated programs
+
+   Generates programs of increasing size (see generate.h) and times a
+   part of the compiler on each; -bench selects which part.  Build with
+   the Typechecker's sources, the code generator and the parser, leaving
+   out parsedj's main(), e.g.
+     bison -b dj Typechecker/dj.y
+     flex "Parser & Lexer/dj.l"
+     gcc -O2 -DNO_PARSEDJ_MAIN -ITypechecker -I"Code Gen" Tools/benchdj.c
+         Tools/generate.c dj.tab.c Typechecker/ast.c Typechecker/intern.c
+         Typechecker/arena.c Typechecker/symtbl.c Typechecker/typecheck.c
+         Typechecker/recover.c Typechecker/sha256.c Typechecker/timing.c
+         "Code Gen/codegen.c" "Code Gen/dism.c" "Code Gen/peephole.c"
+         -lpthread -lm -o benchdj
+   (for the hand-written scanner, skip flex and add -DHANDSCAN
+   -I"Parser & Lexer" to the gcc line) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "generate.h"
+#include "ast.h"
+#include "symtbl.h"
+#include "typecheck.h"
+#include "codegen.h"
+#include "intern.h"
+#include "recover.h"
+#include "timing.h"
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Create a new temporary file, named path (a mkstemp() template) */
+static void makeTempFile(char *path) {
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    printf("ERROR: could not create a temporary file\n");
+    exit(-1);
+  }
+  close(fd);
+}
+
+/* -bench layout: walking compactAST()'s layout and a tree of separately
+   allocated nodes */
+#define WALK_REPEATS 5
+
+static void layoutDefaults(GenOptions *opts, int *from, int *to) {
+  (void)opts;
+  *from = 1000;
+  *to = 16000;
+}
+
+/* A copy of t with each node and each list cell malloc'd on its own, in
+   the order the parser makes them (children before their parent), as
+   trees were laid out before compactAST() */
+static ASTree *linkedCopy(ASTree *t) {
+  if (t == NULL) return NULL;
+  int m = 0;
+  for (ASTList *c = t->children; c != NULL; c = c->next) m++;
+  ASTree **children = malloc(sizeof(ASTree *) * (m > 0 ? m : 1));
+  if (children == NULL) {
+    printf("ERROR: malloc failed in linkedCopy()\n");
+    exit(-1);
+  }
+  int i = 0;
+  for (ASTList *c = t->children; c != NULL; c = c->next)
+    children[i++] = linkedCopy(c->data);
+  ASTree *copy = malloc(sizeof(ASTree));
+  if (copy == NULL) {
+    printf("ERROR: malloc failed in linkedCopy()\n");
+    exit(-1);
+  }
+  *copy = *t;
+  copy->children = copy->childrenTail = NULL;
+  for (i = 0; i < m; i++) {
+    ASTList *cell = malloc(sizeof(ASTList));
+    if (cell == NULL) {
+      printf("ERROR: malloc failed in linkedCopy()\n");
+      exit(-1);
+    }
+    cell->data = children[i];
+    cell->next = NULL;
+    if (copy->childrenTail == NULL) copy->children = cell;
+    else copy->childrenTail->next = cell;
+    copy->childrenTail = cell;
+  }
+  free(children);
+  return copy;
+}
+
+static void freeLinkedCopy(ASTree *t) {
+  if (t == NULL) return;
+  ASTList *c = t->children;
+  while (c != NULL) {
+    ASTList *next = c->next;
+    freeLinkedCopy(c->data);
+    free(c);
+    c = next;
+  }
+  free(t);
+}
+
+/* Number of nodes in t */
+static long countNodes(ASTree *t) {
+  if (t == NULL) return 0;
+  long n = 1;
+  for (ASTList *c = t->children; c != NULL; c = c->next) n += countNodes(c->data);
+  return n;
+}
+
+/* where walks leave their node counts, so they aren't optimized away */
+static volatile long walkedNodes;
+
+/* Best of WALK_REPEATS full walks of t, in seconds */
+static double bestWalkTime(ASTree *t) {
+  double best = -1;
+  for (int i = 0; i < WALK_REPEATS; i++) {
+    double start = now();
+    walkedNodes = countNodes(t);
+    double seconds = now() - start;
+    if (best < 0 || seconds < best) best = seconds;
+  }
+  return best;
+}
+
+/* Seconds to build the symbol tables for t */
+static double symbolTablesTime(ASTree *t) {
+  double start = now();
+  setupSymbolTables(t);
+  double seconds = now() - start;
+  releaseSymbolTables();
+  return seconds;
+}
+
+static void benchLayout(GenOptions *opts, int from, int to) {
+  printf("(%zu-byte nodes, %zu-byte list cells)\n", sizeof(ASTree),
+         sizeof(ASTList));
+  printf("%8s %9s %12s %12s %12s %12s\n", "classes", "nodes",
+         "compact ns", "linked ns", "compact ms", "linked ms");
+  printf("%8s %9s %12s %12s %12s %12s\n", "", "", "walk/node",
+         "walk/node", "symtbl", "symtbl");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    ASTree *generated = generateProgram(opts, NULL);
+    ASTree *linked = linkedCopy(generated);
+    ASTree *compact = compactAST(generated);
+    long nodes = countNodes(compact);
+    double compactWalk = bestWalkTime(compact);
+    double linkedWalk = bestWalkTime(linked);
+    double compactSymtbl = symbolTablesTime(compact);
+    double linkedSymtbl = symbolTablesTime(linked);
+    printf("%8d %9ld %12.2f %12.2f %12.2f %12.2f\n", n, nodes,
+           compactWalk / nodes * 1e9, linkedWalk / nodes * 1e9,
+           compactSymtbl * 1e3, linkedSymtbl * 1e3);
+    freeLinkedCopy(linked);
+    releaseAST();
+  }
+}
+
+/* the compiler that -bench latency runs */
+static char *djcPath = "./djc";
+
+/* Compile path (to path.dism) in a new djc process; returns nonzero if
+   the compile failed */
+static int compileInNewProcess(char *path) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (freopen("/dev/null", "w", stdout) == NULL) _exit(127);
+    execl(djcPath, djcPath, path, (char *)NULL);
+    _exit(127);
+  }
+  int status;
+  if (pid < 0 || waitpid(pid, &status, 0) != pid) return 1;
+  return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+/* A "djc -serve" process and the pipes to and from it */
+typedef struct {
+  pid_t pid;
+  FILE *requests;
+  FILE *replies;
+} Server;
+
+static void startServer(Server *server) {
+  int toServer[2], fromServer[2];
+  if (pipe(toServer) != 0 || pipe(fromServer) != 0) {
+    printf("ERROR: could not make pipes to the compile server\n");
+    exit(-1);
+  }
+  fflush(stdout);
+  server->pid = fork();
+  if (server->pid == 0) {
+    dup2(toServer[0], STDIN_FILENO);
+    dup2(fromServer[1], STDOUT_FILENO);
+    close(toServer[0]);
+    close(toServer[1]);
+    close(fromServer[0]);
+    close(fromServer[1]);
+    execl(djcPath, djcPath, "-serve", (char *)NULL);
+    _exit(127);
+  }
+  close(toServer[0]);
+  close(fromServer[1]);
+  server->requests = fdopen(toServer[1], "w");
+  server->replies = fdopen(fromServer[0], "r");
+  if (server->pid < 0 || server->requests == NULL || server->replies == NULL) {
+    printf("ERROR: could not start %s -serve\n", djcPath);
+    exit(-1);
+  }
+}
+
+static void stopServer(Server *server) {
+  fprintf(server->requests, "quit\n");
+  fclose(server->requests);
+  fclose(server->replies);
+  waitpid(server->pid, NULL, 0);
+}
+
+/* Have server compile path to dismPath; returns nonzero if the compile
+   failed */
+static int compileOnServer(Server *server, char *path, char *dismPath) {
+  fprintf(server->requests, "compile %s %s\n", path, dismPath);
+  fflush(server->requests);
+  char line[4096];
+  /* the compiler's messages come first, then "ok DISM" or "error" */
+  while (fgets(line, sizeof line, server->replies) != NULL) {
+    if (strncmp(line, "ok ", 3) == 0) return 0;
+    if (strcmp(line, "error\n") == 0) return 1;
+  }
+  printf("ERROR: the compile server stopped\n");
+  exit(-1);
+}
+
+/* -bench latency: the cost of one compile request, made to a compile
+   server or run as a new compiler process */
+#define LATENCY_REQUESTS 20
+
+static void latencyDefaults(GenOptions *opts, int *from, int *to) {
+  (void)opts;
+  *from = 1;
+  *to = 4096;
+}
+
+/* Write a program of n printNat() expressions to path.  These programs
+   have no classes or locals, which the generator's programs always
+   have, so that the typechecker accepts them and every phase runs. */
+static void writeMainOnlyProgram(char *path, int n) {
+  FILE *source = fopen(path, "w");
+  if (source == NULL) {
+    printf("ERROR: could not open file %s\n", path);
+    exit(-1);
+  }
+  fprintf(source, "main {\n");
+  for (int i = 0; i < n; i++)
+    fprintf(source, "  printNat(%d * (%d + 1) - %d);\n", i, i, i % 7);
+  fprintf(source, "}\n");
+  fclose(source);
+}
+
+static void benchLatency(GenOptions *opts, int from, int to) {
+  (void)opts;
+  char path[] = "/tmp/benchdjXXXXXX";
+  makeTempFile(path);
+  char dismPath[sizeof path + 5];
+  sprintf(dismPath, "%s.dism", path);
+  Server server;
+  startServer(&server);
+  printf("%8s %12s %12s %12s\n", "exprs", "process ms", "server ms",
+         "saved ms");
+  for (int n = from; n <= to; n *= 4) {
+    writeMainOnlyProgram(path, n);
+    double seconds[2];
+    for (int way = 0; way < 2; way++) {
+      int failures = 0;
+      double start = now();
+      for (int i = 0; i < LATENCY_REQUESTS; i++)
+        failures += way == 0 ? compileInNewProcess(path)
+                             : compileOnServer(&server, path, dismPath);
+      seconds[way] = (now() - start) / LATENCY_REQUESTS;
+      if (failures > 0) printf("ERROR: %d compiles failed\n", failures);
+    }
+    printf("%8d %12.3f %12.3f %12.3f\n", n, seconds[0] * 1e3,
+           seconds[1] * 1e3, (seconds[0] - seconds[1]) * 1e3);
+  }
+  stopServer(&server);
+  remove(path);
+  remove(dismPath);
+}
+
+/* -bench djast: loading a saved .djast file against parsing the source */
+static void djastDefaults(GenOptions *opts, int *from, int *to) {
+  (void)opts;
+  *from = 500;
+  *to = 8000;
+}
+
+static long fileBytes(char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) return 0;
+  fseek(f, 0, SEEK_END);
+  long bytes = ftell(f);
+  fclose(f);
+  return bytes;
+}
+
+static void benchDjast(GenOptions *opts, int from, int to) {
+  char path[] = "/tmp/benchdjXXXXXX";
+  makeTempFile(path);
+  char astPath[sizeof path + 6];
+  sprintf(astPath, "%s.djast", path);
+  printf("%8s %9s %9s %9s %10s %10s %8s\n", "classes", "nodes", "dj MB",
+         "djast MB", "parse ms", "load ms", "speedup");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    FILE *source = fopen(path, "w");
+    if (source == NULL) {
+      printf("ERROR: could not open file %s\n", path);
+      exit(-1);
+    }
+    long nodes = countNodes(generateProgram(opts, source));
+    fclose(source);
+    releaseAST();
+    releaseNames();
+
+    double start = now();
+    ASTree *program = parseFile(path, 0, 0);
+    double parseSeconds = now() - start;
+    if (writeASTFile(program, astPath) != 0) exit(-1);
+    releaseAST();
+    releaseNames();
+    start = now();
+    loadASTFile(astPath);
+    double loadSeconds = now() - start;
+    releaseAST();
+    releaseNames();
+    printf("%8d %9ld %9.2f %9.2f %10.2f %10.2f %7.1fx\n", n, nodes,
+           fileBytes(path) / 1e6, fileBytes(astPath) / 1e6,
+           parseSeconds * 1e3, loadSeconds * 1e3, parseSeconds / loadSeconds);
+  }
+  remove(path);
+  remove(astPath);
+}
+
+/* -bench tokens: the scanner's throughput on multi-megabyte programs */
+#define LEX_REPEATS 3
+
+static void tokensDefaults(GenOptions *opts, int *from, int *to) {
+  (void)opts;
+  *from = 2000;
+  *to = 32000;
+}
+
+/* Best of LEX_REPEATS times to lex path (through yyin, or a memory
+   mapping if useMmap), in seconds */
+static double bestLexTime(char *path, int useMmap, int *numTokens) {
+  double best = -1;
+  for (int i = 0; i < LEX_REPEATS; i++) {
+    double start = now();
+    *numTokens = lexFile(path, useMmap);
+    double seconds = now() - start;
+    if (best < 0 || seconds < best) best = seconds;
+  }
+  return best;
+}
+
+static void benchTokens(GenOptions *opts, int from, int to) {
+  char path[] = "/tmp/benchdjXXXXXX";
+  makeTempFile(path);
+  printf("%8s %8s %10s %10s %10s %10s %10s\n", "classes", "MB", "tokens",
+         "yyin ms", "mmap ms", "Mtokens/s", "mmap MB/s");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    FILE *source = fopen(path, "w");
+    if (source == NULL) {
+      printf("ERROR: could not open file %s\n", path);
+      exit(-1);
+    }
+    generateProgram(opts, source);
+    double mb = ftell(source) / 1e6;
+    fclose(source);
+
+    int numTokens;
+    double yyinSeconds = bestLexTime(path, 0, &numTokens);
+    double mmapSeconds = bestLexTime(path, 1, &numTokens);
+    printf("%8d %8.2f %10d %10.2f %10.2f %10.1f %10.1f\n", n, mb, numTokens,
+           yyinSeconds * 1e3, mmapSeconds * 1e3, numTokens / mmapSeconds / 1e6,
+           mb / mmapSeconds);
+  }
+  remove(path);
+}
+
+/* -bench lookup: class, field and method lookups by name, in classes
+   with many members */
+static void lookupDefaults(GenOptions *opts, int *from, int *to) {
+  opts->fields = 50;
+  opts->methods = 50;
+  opts->exprDepth = 1;
+  opts->mainLength = 1;
+  *from = 1250;
+  *to = 10000;
+}
+
+/* The field named nameNum of class cls, found as symtbl.c did before
+   its hash indexes: by scanning each class's fields up the chain */
+static VarDecl *scanForField(int cls, int nameNum) {
+  for (int depth = 0; cls >= 0 && depth < numClasses; cls = classesST[cls].superclass, depth++)
+    for (int i = 0; i < classesST[cls].numVars; i++)
+      if (classesST[cls].varList[i].varNameNum == nameNum) return &classesST[cls].varList[i];
+  return NULL;
+}
+
+/* Same as scanForField, for methods */
+static MethodDecl *scanForMethod(int cls, int nameNum) {
+  for (int depth = 0; cls >= 0 && depth < numClasses; cls = classesST[cls].superclass, depth++)
+    for (int i = 0; i < classesST[cls].numMethods; i++)
+      if (classesST[cls].methodList[i].methodNameNum == nameNum) return &classesST[cls].methodList[i];
+  return NULL;
+}
+
+/* The class named nameNum, found by scanning classesST, as
+   classNameToNumber() did before the class index */
+static int scanForClass(int nameNum) {
+  for (int c = 0; c < numClasses; c++)
+    if (classesST[c].classNameNum == nameNum) return c;
+  return -3;
+}
+
+/* Look up every class by name, with the index (indexed nonzero) or by
+   scanning */
+static void lookUpClasses(int indexed) {
+  int wrong = 0;
+  for (int c = 1; c < numClasses; c++) {
+    int name = classesST[c].classNameNum;
+    wrong += (indexed ? classNumberOf(name) : scanForClass(name)) != c;
+  }
+  if (wrong > 0) printf("ERROR: %d class lookups failed\n", wrong);
+}
+
+/* Look up every field and method each class has, declared or
+   inherited, with the indexes (indexed nonzero) or with the scans
+   above; returns the number of lookups */
+static long lookUpMembers(int indexed) {
+  long lookups = 0, found = 0;
+  for (int c = 1; c < numClasses; c++) {
+    int depth = 0;
+    for (int a = c; a > 0 && depth < numClasses; a = classesST[a].superclass, depth++) {
+      for (int i = 0; i < classesST[a].numVars; i++, lookups++) {
+        int name = classesST[a].varList[i].varNameNum;
+        found += (indexed ? findField(c, name, NULL) : scanForField(c, name)) != NULL;
+      }
+      for (int i = 0; i < classesST[a].numMethods; i++, lookups++) {
+        int name = classesST[a].methodList[i].methodNameNum;
+        found += (indexed ? findMethod(c, name, NULL) : scanForMethod(c, name)) != NULL;
+      }
+    }
+  }
+  if (found != lookups) printf("ERROR: %ld of %ld lookups failed\n", lookups - found, lookups);
+  return lookups;
+}
+
+static void benchLookup(GenOptions *opts, int from, int to) {
+  printf("%8s %8s %10s %10s %12s %12s %12s %12s\n", "classes", "members",
+         "lookups", "symtbl s", "ns/member", "ns/scanned", "ns/class",
+         "ns/scanned");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    ASTree *program = generateProgram(opts, NULL);
+    double start = now();
+    setupSymbolTables(program);
+    double symtbl = now() - start;
+    double seconds[4];
+    long lookups = 0;
+    for (int way = 0; way < 4; way++) {
+      start = now();
+      if (way < 2) lookups = lookUpMembers(way == 0);
+      else lookUpClasses(way == 2);
+      seconds[way] = now() - start;
+    }
+    printf("%8d %8d %10ld %10.4f %12.1f %12.1f %12.1f %12.1f\n", n,
+           opts->fields + opts->methods, lookups, symtbl,
+           seconds[0] / lookups * 1e9, seconds[1] / lookups * 1e9,
+           seconds[2] / n * 1e9, seconds[3] / n * 1e9);
+    releaseSymbolTables();
+    releaseAST();
+    releaseNames();
+  }
+}
+
+/* -bench subtype: isSubclass() and commonSuperclass() on deep class
+   trees, against walking up the superclass chains */
+#define SUBTYPE_QUERIES 1000000
+
+static void subtypeDefaults(GenOptions *opts, int *from, int *to) {
+  opts->maxDepth = 1000;
+  opts->fields = 1;
+  opts->methods = 1;
+  opts->exprDepth = 1;
+  opts->mainLength = 1;
+  *from = 2000;
+  *to = 16000;
+}
+
+/* isSubclass() by walking sub's superclass chain, as isSubtype() did
+   before the class tree was numbered */
+static int scanIsSubclass(int sub, int super) {
+  for (int c = sub; c >= 0; c = classesST[c].superclass)
+    if (c == super) return 1;
+  return 0;
+}
+
+/* commonSuperclass() by testing each superclass of c1 in turn, as
+   join() did */
+static int scanCommonSuperclass(int c1, int c2) {
+  for (int c = c1; c >= 0; c = classesST[c].superclass)
+    if (scanIsSubclass(c2, c)) return c;
+  return -3;
+}
+
+/* where the queries leave their answers, so they aren't optimized away */
+static volatile long queryAnswers;
+
+/* Seconds per query for the first count pairs (a[i], b[i]) of class
+   numbers, asked of isSubclass() (way 0), its chain walk (1),
+   commonSuperclass() (2) or its chain walk (3) */
+static double timeQueries(int way, int *a, int *b, int count) {
+  long answers = 0;
+  double start = now();
+  for (int i = 0; i < count; i++) {
+    switch (way) {
+      case 0: answers += isSubclass(a[i], b[i]); break;
+      case 1: answers += scanIsSubclass(a[i], b[i]); break;
+      case 2: answers += commonSuperclass(a[i], b[i]); break;
+      default: answers += scanCommonSuperclass(a[i], b[i]); break;
+    }
+  }
+  queryAnswers = answers;
+  return (now() - start) / count;
+}
+
+static void benchSubtype(GenOptions *opts, int from, int to) {
+  int *a = malloc(sizeof(int) * SUBTYPE_QUERIES);
+  int *b = malloc(sizeof(int) * SUBTYPE_QUERIES);
+  if (a == NULL || b == NULL) {
+    printf("ERROR: malloc failed in benchSubtype()\n");
+    exit(-1);
+  }
+  /* the chain walks take time in proportion to the depth (or its
+     square, for joins), so they answer fewer of the queries */
+  static const int counts[4] =
+    { SUBTYPE_QUERIES, SUBTYPE_QUERIES / 10, SUBTYPE_QUERIES, 1000 };
+  printf("%8s %8s %12s %12s %12s %12s\n", "classes", "depth", "ns/subtype",
+         "ns/scanned", "ns/join", "ns/scanned");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    setupSymbolTables(generateProgram(opts, NULL));
+    int depth = 0;
+    for (int c = 0; c < numClasses; c++)
+      if (classesST[c].depth > depth) depth = classesST[c].depth;
+    /* half the pairs are a class and one of its superclasses, so about
+       half the subtype queries succeed */
+    srand(opts->seed);
+    for (int i = 0; i < SUBTYPE_QUERIES; i++) {
+      a[i] = 1 + rand() % (numClasses - 1);
+      b[i] = 1 + rand() % (numClasses - 1);
+      if (i % 2 == 0) {
+        b[i] = a[i];
+        for (int up = rand() % (classesST[a[i]].depth + 1); up > 0; up--)
+          b[i] = classesST[b[i]].superclass;
+      }
+    }
+    double seconds[4];
+    for (int way = 0; way < 4; way++)
+      seconds[way] = timeQueries(way, a, b, counts[way]);
+    printf("%8d %8d %12.1f %12.1f %12.1f %12.1f\n", n, depth,
+           seconds[0] * 1e9, seconds[1] * 1e9, seconds[2] * 1e9,
+           seconds[3] * 1e9);
+    releaseSymbolTables();
+    releaseAST();
+    releaseNames();
+  }
+  free(a);
+  free(b);
+}
+
+/* -bench decls: how checkClasses()'s declaration checks (all of
+   typecheckProgram() but the expressions it types) scale with the
+   number of declarations, on long inheritance chains */
+#define DECLS_REPEATS 5
+
+static void declsDefaults(GenOptions *opts, int *from, int *to) {
+  opts->maxDepth = 100;
+  opts->fields = 10;
+  opts->methods = 10;
+  opts->exprDepth = 1;
+  opts->mainLength = 1;
+  *from = 500;
+  *to = 8000;
+}
+
+/* Type every method body and the main block, as typecheckProgram()
+   does between its declaration checks */
+static void typeBodies(void) {
+  for (int i = 0; i < numClasses; i++)
+    for (int j = 0; j < classesST[i].numMethods; j++)
+      if (classesST[i].methodList[j].bodyExprs != NULL)
+        typeExprs(classesST[i].methodList[j].bodyExprs, i, j);
+  typeExprs(mainExprs, -1, -1);
+}
+
+/* Best of DECLS_REPEATS runs of phase, in seconds */
+static double bestPhaseTime(void (*phase)(void)) {
+  double best = -1;
+  for (int r = 0; r < DECLS_REPEATS; r++) {
+    double start = now();
+    phase();
+    double seconds = now() - start;
+    if (best < 0 || seconds < best) best = seconds;
+  }
+  return best;
+}
+
+static void benchDecls(GenOptions *opts, int from, int to) {
+  printf("%8s %9s %12s %12s %12s %12s\n", "classes", "decls",
+         "typecheck ms", "bodies ms", "decls ms", "ns/decl");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    setupSymbolTables(generateProgram(opts, NULL));
+    long decls = 0;
+    for (int c = 1; c < numClasses; c++)
+      decls += 1 + classesST[c].numVars + classesST[c].numMethods;
+    double all = bestPhaseTime(typecheckProgram);
+    double bodies = bestPhaseTime(typeBodies);
+    printf("%8d %9ld %12.2f %12.2f %12.2f %12.1f\n", n, decls, all * 1e3,
+           bodies * 1e3, (all - bodies) * 1e3, (all - bodies) / decls * 1e9);
+    releaseSymbolTables();
+    releaseAST();
+    releaseNames();
+  }
+}
+
+/* -bench scaling: how each phase of the compiler scales with the
+   number of AST nodes, as the exponent k in time ~ nodes^k between
+   successive sizes; phases with k above SUPERLINEAR are flagged */
+#define SUPERLINEAR 1.25
+#define MAX_SIZES 32
+
+enum { GENERATE, LEX, PARSE, SYMTBL, TYPECHECK, CODEGEN, NUM_PHASES };
+static const char *phaseNames[NUM_PHASES] =
+  { "generate", "lex", "parse", "symtbl", "typecheck", "codegen" };
+
+/* One program's measurements; a time < 0 means the phase failed */
+typedef struct {
+  int numClasses;
+  long nodes;
+  int tokens;
+  double seconds[NUM_PHASES];
+} ScalingRow;
+
+/* typecheckProgramParallel()'s thread count (-tcthreads) */
+static int typecheckThreads = 1;
+
+static char *scalingPath;
+static ASTree *scalingProgram;
+static int scalingTokens;
+
+static void runLex(void *arg) {
+  (void)arg;
+  scalingTokens = lexFile(scalingPath, 0);
+}
+static void runParse(void *arg) {
+  (void)arg;
+  scalingProgram = parseFile(scalingPath, 0, 0);
+}
+static void runSymbolTables(void *arg) {
+  (void)arg;
+  setupSymbolTables(scalingProgram);
+}
+static void runTypecheck(void *arg) {
+  (void)arg;
+  typecheckProgramParallel(typecheckThreads);
+}
+static void runCodegen(void *arg) {
+  (void)arg;
+  FILE *out = fopen("/dev/null", "w");
+  if (out == NULL) {
+    printf("ERROR: could not open /dev/null\n");
+    compileFailed(1);
+  }
+  generateDISM(out);
+  fclose(out);
+}
+
+/* Time phase (run under tryCompile()) in seconds, or -1 if it failed */
+static double timePhase(void (*phase)(void *arg)) {
+  double start = now();
+  if (tryCompile(phase, NULL)) {
+    finishSource();
+    return -1;
+  }
+  return now() - start;
+}
+
+static void measureScaling(GenOptions *opts, ScalingRow *row) {
+  row->numClasses = opts->numClasses;
+  FILE *source = fopen(scalingPath, "w");
+  if (source == NULL) {
+    printf("ERROR: could not open file %s\n", scalingPath);
+    exit(-1);
+  }
+  double start = now();
+  scalingProgram = generateProgram(opts, source);
+  row->seconds[GENERATE] = now() - start;
+  fclose(source);
+  row->nodes = countNodes(scalingProgram);
+
+  scalingTokens = 0;
+  row->seconds[LEX] = timePhase(runLex);
+  row->tokens = scalingTokens;
+  /* the later phases run on the parsed AST, laid out as the compiler
+     lays it out; the generator's AST stands in if parsing fails */
+  ASTree *generated = scalingProgram;
+  row->seconds[PARSE] = timePhase(runParse);
+  if (row->seconds[PARSE] < 0) scalingProgram = generated;
+  row->seconds[SYMTBL] = timePhase(runSymbolTables);
+  row->seconds[TYPECHECK] = row->seconds[SYMTBL] < 0 ? -1 : timePhase(runTypecheck);
+  row->seconds[CODEGEN] = row->seconds[TYPECHECK] < 0 ? -1 : timePhase(runCodegen);
+
+  releaseSymbolTables();
+  releaseAST();
+  releaseNames();
+}
+
+static void printScaling(ScalingRow *rows, int numRows) {
+  printf("%8s %9s %9s", "classes", "nodes", "tokens");
+  for (int p = 0; p < NUM_PHASES; p++) printf(" %10s", phaseNames[p]);
+  printf(" %12s\n", "nodes/sec");
+  for (int r = 0; r < numRows; r++) {
+    printf("%8d %9ld %9d", rows[r].numClasses, rows[r].nodes, rows[r].tokens);
+    double total = 0;
+    for (int p = 0; p < NUM_PHASES; p++) {
+      if (rows[r].seconds[p] < 0) printf(" %10s", "failed");
+      else printf(" %10.4f", rows[r].seconds[p]);
+      /* throughput of the phases that build the output from the AST */
+      if (p >= SYMTBL && rows[r].seconds[p] > 0) total += rows[r].seconds[p];
+    }
+    if (total > 0) printf(" %12.0f\n", rows[r].nodes / total);
+    else printf(" %12s\n", "-");
+  }
+
+  printf("\nScaling exponent k against the previous size "
+         "(time ~ nodes^k; * marks k > %.2f):\n", SUPERLINEAR);
+  printf("%8s %9s %9s", "classes", "", "");
+  for (int p = 0; p < NUM_PHASES; p++) printf(" %10s", phaseNames[p]);
+  printf("\n");
+  for (int r = 1; r < numRows; r++) {
+    printf("%8d %9s %9s", rows[r].numClasses, "", "");
+    for (int p = 0; p < NUM_PHASES; p++) {
+      double before = rows[r - 1].seconds[p], after = rows[r].seconds[p];
+      if (before <= 0 || after <= 0) {
+        printf(" %10s", "-");
+        continue;
+      }
+      double k = log(after / before) / log((double)rows[r].nodes / rows[r - 1].nodes);
+      printf(" %9.2f%c", k, k > SUPERLINEAR ? '*' : ' ');
+    }
+    printf("\n");
+  }
+}
+
+static void benchScaling(GenOptions *opts, int from, int to) {
+  char path[] = "/tmp/benchdjXXXXXX";
+  makeTempFile(path);
+  scalingPath = path;
+  ScalingRow rows[MAX_SIZES];
+  int numRows = 0;
+  for (int n = from; n <= to && numRows < MAX_SIZES; n *= 2) {
+    opts->numClasses = n;
+    measureScaling(opts, &rows[numRows++]);
+  }
+  remove(path);
+  printScaling(rows, numRows);
+}
+
+/* -bench emit: generateDISM()'s output rate, writing to a file */
+#define EMIT_REPEATS 3
+
+static void emitDefaults(GenOptions *opts, int *from, int *to) {
+  (void)opts;
+  *from = 1000;
+  *to = 8000;
+}
+
+static void benchEmit(GenOptions *opts, int from, int to) {
+  char path[] = "/tmp/benchdjXXXXXX";
+  makeTempFile(path);
+  printf("%8s %10s %9s %10s %12s %9s\n", "classes", "instrs", "DISM MB",
+         "codegen ms", "instrs/sec", "MB/sec");
+  for (int n = from; n <= to; n *= 2) {
+    opts->numClasses = n;
+    setupSymbolTables(generateProgram(opts, NULL));
+    typecheckProgram();
+    double best = -1;
+    unsigned long instructions = 0;
+    for (int r = 0; r < EMIT_REPEATS; r++) {
+      FILE *out = fopen(path, "w");
+      if (out == NULL) {
+        printf("ERROR: could not open file %s\n", path);
+        exit(-1);
+      }
+      unsigned long before = timedInstructions;
+      double start = now();
+      generateDISM(out);
+      fclose(out);
+      double seconds = now() - start;
+      instructions = timedInstructions - before;
+      if (best < 0 || seconds < best) best = seconds;
+    }
+    double megabytes = fileBytes(path) / 1e6;
+    printf("%8d %10lu %9.2f %10.2f %12.0f %9.1f\n", n, instructions, megabytes,
+           best * 1e3, instructions / best, megabytes / best);
+    releaseSymbolTables();
+    releaseAST();
+    releaseNames();
+  }
+  remove(path);
+}
+
+/* The benchmarks -bench chooses from; the first is the default.
+   defaults (if not NULL) replaces the usual program shape and sizes
+   before the options are applied. */
+typedef struct {
+  const char *name;
+  void (*defaults)(GenOptions *opts, int *from, int *to);
+  void (*run)(GenOptions *opts, int from, int to);
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+  { "layout", layoutDefaults, benchLayout },
+  { "latency", latencyDefaults, benchLatency },
+  { "djast", djastDefaults, benchDjast },
+  { "tokens", tokensDefaults, benchTokens },
+  { "lookup", lookupDefaults, benchLookup },
+  { "subtype", subtypeDefaults, benchSubtype },
+  { "decls", declsDefaults, benchDecls },
+  { "scaling", NULL, benchScaling },
+  { "emit", emitDefaults, benchEmit },
+};
+#define NUM_BENCHMARKS (int)(sizeof benchmarks / sizeof benchmarks[0])
+
+int main(int argc, char **argv) {
+  /* Options:
+     -bench NAME   which benchmark to run (default layout):
+                     layout   a full tree walk, and building the symbol
+                              tables, on compactAST()'s layout and on
+                              separately malloc'd nodes and cells, for
+                              1000..16000 classes
+                     latency  the time per compile request made to a
+                              compile server (djc -serve) and run as a
+                              new djc process, for main blocks of
+                              1..4096 expressions
+                     djast    loading a .djast file against parsing
+                              the program, for 500..8000 classes
+                     tokens   the scanner's throughput on programs of
+                              2000..32000 classes (1..18 MB), read
+                              through yyin and through a memory mapping
+                     lookup   class, field and method lookups, with the
+                              symbol tables' indexes and with linear
+                              scans, in 1250..10000 classes of 100
+                              members
+                     subtype  subtype and join queries, indexed and by
+                              walking superclass chains, in 2000..16000
+                              classes up to 1000 deep
+                     decls    the declaration checks' time per
+                              declaration, in 500..8000 classes of 10
+                              fields and 10 methods, up to 100 deep
+                     scaling  every phase's time, and how it grows
+                              with the number of AST nodes, for
+                              250..8000 classes (errors in a phase are
+                              printed, and the phase reported failed)
+                     emit     generateDISM()'s instructions and
+                              megabytes per second, writing the DISM
+                              code to a file, for 1000..8000 classes
+     -djc PATH     the compiler -bench latency runs (default ./djc)
+     -seed S       random seed
+     -from N       smallest program, in classes (default 250)
+     -to N         largest program; sizes double from -from (default 8000)
+     -depth, -methods, -fields, -nesting, -main  as for gendj
+     -tcthreads N  typecheck on N threads (typecheckProgramParallel()),
+                   for -bench scaling */
+  GenOptions opts;
+  defaultGenOptions(&opts);
+  int from = 250, to = 8000;
+  const Benchmark *bench = &benchmarks[0];
+  for (int arg = 1; arg + 1 < argc; arg += 2)
+    if (strcmp(argv[arg], "-bench") == 0) {
+      bench = NULL;
+      for (int b = 0; b < NUM_BENCHMARKS; b++)
+        if (strcmp(argv[arg + 1], benchmarks[b].name) == 0) bench = &benchmarks[b];
+      break;
+    }
+  if (bench != NULL && bench->defaults != NULL) bench->defaults(&opts, &from, &to);
+  for (int arg = 1; arg < argc; arg += 2) {
+    int value = arg + 1 < argc ? atoi(argv[arg + 1]) : -1;
+    if (strcmp(argv[arg], "-bench") == 0) continue;
+    if (strcmp(argv[arg], "-djc") == 0 && arg + 1 < argc) {
+      djcPath = argv[arg + 1];
+      continue;
+    }
+    if (strcmp(argv[arg], "-seed") == 0) opts.seed = (unsigned int)value;
+    else if (strcmp(argv[arg], "-from") == 0) from = value;
+    else if (strcmp(argv[arg], "-to") == 0) to = value;
+    else if (strcmp(argv[arg], "-depth") == 0) opts.maxDepth = value;
+    else if (strcmp(argv[arg], "-methods") == 0) opts.methods = value;
+    else if (strcmp(argv[arg], "-fields") == 0) opts.fields = value;
+    else if (strcmp(argv[arg], "-nesting") == 0) opts.exprDepth = value;
+    else if (strcmp(argv[arg], "-main") == 0) opts.mainLength = value;
+    else if (strcmp(argv[arg], "-tcthreads") == 0) typecheckThreads = value;
+    else from = -1;
+  }
+  if (bench == NULL || from < 1 || to < from || opts.maxDepth < 1 || opts.exprDepth < 1
+      || opts.methods < 0 || opts.fields < 0 || opts.mainLength < 0
+      || typecheckThreads < 1) {
+    printf("Usage: benchdj [-bench NAME] [-djc PATH] [-seed S] [-from N] [-to N] [-depth D] ");
+    printf("[-methods M] [-fields F] [-nesting E] [-main L] [-tcthreads N]\n");
+    exit(-1);
+  }
+
+  bench->run(&opts, from, to);
+  return 0;
+}
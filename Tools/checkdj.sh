@@ -0,0 +1,36 @@
+#!/bin/sh
+# File checkdj.sh: compile the test programs in Tools/tests with djc
+#
+# Each program must compile, unless its first line is
+# "// error: MESSAGE", in which case djc must reject it with a
+# semantic error containing MESSAGE.  Reports every program that
+# does otherwise.
+# Usage: sh Tools/checkdj.sh [DJC [FILE...]]
+# (DJC defaults to ./djc, and the FILEs to Tools/tests/*.dj; the exit
+# status is the number of failing programs)
+
+djc=${1:-./djc}
+[ $# -ge 1 ] && shift
+[ $# -eq 0 ] && set -- "$(dirname "$0")"/tests/*.dj
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+bad=0
+for f in "$@"; do
+  name=$(basename "$f")
+  cp "$f" "$dir/$name" || exit 1
+  "$djc" "$dir/$name" > "$dir/out" 2>&1
+  status=$?
+  expected=$(sed -n '1s|^// error: ||p' "$f")
+  if [ -z "$expected" ]; then
+    if [ $status -ne 0 ]; then
+      echo "FAILED: $name did not compile: $(head -1 "$dir/out")"
+      bad=$((bad + 1))
+    fi
+  elif [ $status -eq 0 ] || ! grep -q -F "$expected" "$dir/out"; then
+    echo "FAILED: $name was not rejected with \"$expected\": $(head -1 "$dir/out")"
+    bad=$((bad + 1))
+  fi
+done
+echo "$bad failing programs"
+exit $bad
@@ -0,0 +1,56 @@
+/* File gendj.c: write a synthetic DJ program (see generate.h)
+
+   Build with the Typechecker's AST, e.g.
+     gcc -ITypechecker Tools/gendj.c Tools/generate.c Typechecker/ast.c
+         Typechecker/intern.c Typechecker/arena.c Typechecker/recover.c
+         Typechecker/timing.c -o gendj
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generate.h"
+
+int main(int argc, char **argv) {
+  /* Options (defaults in defaultGenOptions()):
+     -seed S      random seed
+     -classes N   number of classes
+     -depth D     longest superclass chain below Object
+     -methods M   methods per class
+     -fields F    fields per class
+     -nesting E   how deeply expressions nest
+     -main L      expressions in the main block */
+  GenOptions opts;
+  defaultGenOptions(&opts);
+  int arg = 1;
+  while (arg + 1 < argc && argv[arg][0] == '-') {
+    int value = atoi(argv[arg + 1]);
+    if (strcmp(argv[arg], "-seed") == 0) opts.seed = (unsigned int)value;
+    else if (strcmp(argv[arg], "-classes") == 0) opts.numClasses = value;
+    else if (strcmp(argv[arg], "-depth") == 0) opts.maxDepth = value;
+    else if (strcmp(argv[arg], "-methods") == 0) opts.methods = value;
+    else if (strcmp(argv[arg], "-fields") == 0) opts.fields = value;
+    else if (strcmp(argv[arg], "-nesting") == 0) opts.exprDepth = value;
+    else if (strcmp(argv[arg], "-main") == 0) opts.mainLength = value;
+    else break;
+    arg += 2;
+  }
+  if (arg != argc - 1 || opts.numClasses < 1
+      || opts.maxDepth < 1 || opts.exprDepth < 1 || opts.methods < 0
+      || opts.fields < 0 || opts.mainLength < 0) {
+    printf("Usage: gendj [-seed S] [-classes N] [-depth D] [-methods M] ");
+    printf("[-fields F] [-nesting E] [-main L] out.dj\n");
+    exit(-1);
+  }
+  FILE *source = fopen(argv[arg], "w");
+  if (source == NULL) {
+    printf("ERROR: could not open file %s\n", argv[arg]);
+    exit(-1);
+  }
+  generateProgram(&opts, source);
+  if (fclose(source) != 0) {
+    printf("ERROR: could not write file %s\n", argv[arg]);
+    exit(-1);
+  }
+  return 0;
+}
@@ -0,0 +1,472 @@
+/* File generate.c: synthetic DJ programs (see generate.h) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generate.h"
+
+#define NAT -1    /* the types nat and Object, as the typechecker */
+#define OBJECT 0  /* numbers types */
+
+typedef struct {
+  char name[24];
+  int type;
+} GenVar;
+
+typedef struct {
+  char name[24];
+  int returnType;
+  int paramType;
+  int isFinal;
+} GenMethod;
+
+typedef struct {
+  int superclass;  /* 0 for Object */
+  int depth;       /* superclasses below Object, plus one */
+  int isFinal;
+  GenVar *fields;
+  int numFields;
+  GenMethod *methods;
+  int numMethods;
+} GenClass;
+
+/* where an expression appears: a method of class cls, or the main
+   block (cls < 0), and the variables declared there */
+typedef struct {
+  int cls;
+  int paramType;   /* the method's parameter p's type */
+  GenVar *locals;
+  int numLocals;
+} GenScope;
+
+static unsigned long long rngState;
+static const GenOptions *opt;
+static GenClass *classes;  /* classes[1..numClasses]; [0] is Object */
+static FILE *out;
+static int line;
+
+/* xorshift64*: a small generator that is the same on every platform */
+static unsigned int nextRandom(void) {
+  rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return (unsigned int)((rngState * 2685821657736338717ULL) >> 32);
+}
+
+static int randomBelow(int n) { return n > 0 ? (int)(nextRandom() % n) : 0; }
+
+static void emit(const char *text) {
+  if (out != NULL) fputs(text, out);
+  for (; *text; text++) if (*text == '\n') line++;
+}
+
+static const char *typeName(int type) {
+  static char name[24];
+  if (type == 0) return "Object";
+  sprintf(name, "C%d", type);
+  return name;
+}
+
+/* nonzero iff class sub is class super or one of its subclasses */
+static int isSub(int sub, int super) {
+  if (super == 0) return 1;
+  for (; sub > 0; sub = classes[sub].superclass)
+    if (sub == super) return 1;
+  return 0;
+}
+
+/* cls or one of its superclasses (other than Object), at random */
+static int randomAncestor(int cls) {
+  for (int steps = randomBelow(classes[cls].depth); steps > 0 && cls > 0; steps--)
+    cls = classes[cls].superclass;
+  return cls;
+}
+
+static int randomClass(void) { return randomBelow(opt->numClasses + 1); }
+
+/* AST BUILDING */
+
+static ASTree *idNode(const char *name) {
+  return newAST(AST_ID, NULL, 0, (char *)name, line);
+}
+
+static ASTree *node(ASTNodeType t, ASTree *a, ASTree *b, ASTree *c) {
+  ASTree *n = newAST(t, a, 0, NULL, line);
+  if (b) appendToChildrenList(n, b);
+  if (c) appendToChildrenList(n, c);
+  return n;
+}
+
+/* a list node with no children */
+static ASTree *emptyList(ASTNodeType t) {
+  ASTree *n = newAST(t, NULL, 0, NULL, line);
+  n->children = n->childrenTail = NULL;
+  return n;
+}
+
+static void appendOrStart(ASTree **list, ASTNodeType t, ASTree *item) {
+  if (*list == NULL || (*list)->children == NULL) *list = newAST(t, item, 0, NULL, line);
+  else appendToChildrenList(*list, item);
+}
+
+static ASTree *varDecl(const char *name, int type) {
+  return node(VAR_DECL, idNode(name), idNode(typeName(type)), NULL);
+}
+
+/* EXPRESSIONS */
+
+static ASTree *genExpr(int type, int depth, const GenScope *s, int nonNull);
+
+/* a variable visible in s whose type is a subtype of type, or NULL */
+static GenVar *pickVar(int type, const GenScope *s, GenVar *param) {
+  GenVar *found = NULL;
+  int seen = 0;
+  /* reservoir sampling over the locals, the parameter and the fields */
+  for (int i = 0; i < s->numLocals; i++)
+    if (isSub(s->locals[i].type, type) && randomBelow(++seen) == 0) found = &s->locals[i];
+  if (s->cls > 0) {
+    if (isSub(param->type, type) && randomBelow(++seen) == 0) found = param;
+    for (int c = s->cls; c > 0; c = classes[c].superclass)
+      for (int i = 0; i < classes[c].numFields; i++)
+        if (isSub(classes[c].fields[i].type, type) && randomBelow(++seen) == 0)
+          found = &classes[c].fields[i];
+  }
+  return found;
+}
+
+/* a field (or, if methods, a method) some class has whose type is a
+   subtype of type; sets *receiver to that class */
+static void *pickMember(int type, int methods, int *receiver) {
+  for (int tries = 0; tries < 8; tries++) {
+    int cls = 1 + randomBelow(opt->numClasses);
+    GenClass *owner = &classes[randomAncestor(cls)];
+    if (methods && owner->numMethods > 0) {
+      GenMethod *m = &owner->methods[randomBelow(owner->numMethods)];
+      if (isSub(m->returnType, type)) { *receiver = cls; return m; }
+    }
+    if (!methods && owner->numFields > 0) {
+      GenVar *f = &owner->fields[randomBelow(owner->numFields)];
+      if (isSub(f->type, type)) { *receiver = cls; return f; }
+    }
+  }
+  return NULL;
+}
+
+static ASTree *genNat(int depth, const GenScope *s) {
+  if (depth >= opt->exprDepth) return newAST(NAT_LITERAL_EXPR, NULL, randomBelow(100), NULL, line);
+  GenVar param = { "p", s->paramType };
+  GenVar *v;
+  switch (randomBelow(9)) {
+  case 0: return node(PLUS_EXPR, genNat(depth + 1, s), genNat(depth + 1, s), NULL);
+  case 1: return node(MINUS_EXPR, genNat(depth + 1, s), genNat(depth + 1, s), NULL);
+  case 2: return node(TIMES_EXPR, genNat(depth + 1, s), genNat(depth + 1, s), NULL);
+  case 3: return node(LESS_THAN_EXPR, genNat(depth + 1, s), genNat(depth + 1, s), NULL);
+  case 4:
+    /* a variable on the left has exactly its declared type, so any
+       subtype of that type can go on the right */
+    if ((v = pickVar(OBJECT, s, &param)) != NULL)
+      return node(EQUALITY_EXPR, node(ID_EXPR, idNode(v->name), NULL, NULL),
+                  genExpr(v->type, depth + 1, s, 0), NULL);
+    return newAST(NAT_LITERAL_EXPR, NULL, randomBelow(100), NULL, line);
+  case 5: return node(NOT_EXPR, genNat(depth + 1, s), NULL, NULL);
+  case 6: return node(OR_EXPR, genNat(depth + 1, s), genNat(depth + 1, s), NULL);
+  case 7: return node(PRINT_EXPR, genNat(depth + 1, s), NULL, NULL);
+  default: return newAST(NAT_LITERAL_EXPR, NULL, randomBelow(100), NULL, line);
+  }
+}
+
+/* an expression of a subtype of type (nat or a class), which is not
+   null itself if nonNull */
+static ASTree *genExpr(int type, int depth, const GenScope *s, int nonNull) {
+  if (type == NAT) return genNat(depth, s);
+  GenVar param = { "p", s->paramType };
+  GenVar *v;
+  int receiver;
+
+  if (depth < opt->exprDepth) {
+    switch (randomBelow(6)) {
+    case 0:
+      if ((v = pickVar(type, s, &param)) != NULL)
+        return node(ASSIGN_EXPR, idNode(v->name), genExpr(v->type, depth + 1, s, 0), NULL);
+      break;
+    case 1:
+      if ((v = pickMember(type, 0, &receiver)) != NULL)
+        return node(DOT_ID_EXPR, genExpr(receiver, depth + 1, s, 1), idNode(v->name), NULL);
+      break;
+    case 2:
+      if ((v = pickMember(type, 0, &receiver)) != NULL)
+        return node(DOT_ASSIGN_EXPR, genExpr(receiver, depth + 1, s, 1), idNode(v->name),
+                    genExpr(v->type, depth + 1, s, 0));
+      break;
+    case 3:
+    case 4: {
+      GenMethod *m = pickMember(type, 1, &receiver);
+      if (m != NULL)
+        return node(DOT_METHOD_CALL_EXPR, genExpr(receiver, depth + 1, s, 1), idNode(m->name),
+                    genExpr(m->paramType, depth + 1, s, 0));
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  switch (randomBelow(nonNull ? 3 : 4)) {
+  case 0:
+    if ((v = pickVar(type, s, &param)) != NULL) return node(ID_EXPR, idNode(v->name), NULL, NULL);
+    break;
+  case 1:
+    if (s->cls > 0 && isSub(s->cls, type)) return newAST(THIS_EXPR, NULL, 0, NULL, line);
+    break;
+  case 3:
+    return newAST(NULL_EXPR, NULL, 0, NULL, line);
+  default:
+    break;
+  }
+  /* new C() for a subclass C of type, if a few tries find one */
+  int cls = type;
+  for (int tries = 0; tries < 4; tries++) {
+    int c = 1 + randomBelow(opt->numClasses);
+    if (isSub(c, type)) { cls = c; break; }
+  }
+  return node(NEW_EXPR, idNode(typeName(cls)), NULL, NULL);
+}
+
+/* SOURCE TEXT (every compound subexpression is parenthesized) */
+
+static void writeExpr(ASTree *t) {
+  if (out == NULL) return;
+  ASTList *c = t->children;
+  const char *op = NULL;
+  switch (t->typ) {
+  case PLUS_EXPR: op = " + "; break;
+  case MINUS_EXPR: op = " - "; break;
+  case TIMES_EXPR: op = " * "; break;
+  case EQUALITY_EXPR: op = " == "; break;
+  case LESS_THAN_EXPR: op = " < "; break;
+  case OR_EXPR: op = " || "; break;
+  case NOT_EXPR: fputs("!(", out); writeExpr(c->data); fputs(")", out); return;
+  case PRINT_EXPR: fputs("printNat(", out); writeExpr(c->data); fputs(")", out); return;
+  case NAT_LITERAL_EXPR: fprintf(out, "%u", t->natVal); return;
+  case NULL_EXPR: fputs("null", out); return;
+  case THIS_EXPR: fputs("this", out); return;
+  case NEW_EXPR: fprintf(out, "new %s()", c->data->idVal); return;
+  case ID_EXPR: fputs(c->data->idVal, out); return;
+  case ASSIGN_EXPR:
+    fprintf(out, "(%s = ", c->data->idVal);
+    writeExpr(c->next->data);
+    fputs(")", out);
+    return;
+  case DOT_ID_EXPR:
+  case DOT_ASSIGN_EXPR:
+  case DOT_METHOD_CALL_EXPR:
+    fputs(t->typ == DOT_ASSIGN_EXPR ? "((" : "(", out);
+    writeExpr(c->data);
+    fprintf(out, ").%s", c->next->data->idVal);
+    if (t->typ == DOT_ASSIGN_EXPR) {
+      fputs(" = (", out);
+      writeExpr(c->next->next->data);
+      fputs("))", out);
+    } else if (t->typ == DOT_METHOD_CALL_EXPR) {
+      fputs("(", out);
+      writeExpr(c->next->next->data);
+      fputs(")", out);
+    }
+    return;
+  default:
+    return;
+  }
+  fputs("(", out);
+  writeExpr(c->data);
+  fputs(op, out);
+  writeExpr(c->next->data);
+  fputs(")", out);
+}
+
+/* an expression statement: its AST, with the text written on one line */
+static ASTree *statement(ASTree *e, const char *indent) {
+  emit(indent);
+  writeExpr(e);
+  emit(";\n");
+  return e;
+}
+
+/* DECLARATIONS */
+
+/* choose superclasses, fields and method signatures for every class */
+static void planClasses(void) {
+  int deepest = 0;
+  for (int i = 1; i <= opt->numClasses; i++) {
+    GenClass *cls = &classes[i];
+    int depth = 1 + randomBelow(deepest + 1);
+    if (randomBelow(2) == 0) depth = deepest + 1;
+    if (depth > opt->maxDepth) depth = opt->maxDepth;
+    cls->superclass = 0;
+    if (depth > 1) {
+      /* a random earlier class one level up (one exists, since
+         depth - 1 <= deepest) */
+      int start = 1 + randomBelow(i - 1);
+      for (int k = 0; k < i - 1; k++) {
+        int c = 1 + (start - 1 + k) % (i - 1);
+        if (classes[c].depth == depth - 1) { cls->superclass = c; break; }
+      }
+    }
+    cls->depth = depth;
+    if (depth > deepest) deepest = depth;
+
+    cls->numFields = opt->fields;
+    cls->fields = malloc(sizeof(GenVar) * (opt->fields + 1));
+    for (int k = 0; k < opt->fields; k++) {
+      sprintf(cls->fields[k].name, "f%d_%d", i, k);
+      cls->fields[k].type = randomClass();
+    }
+
+    cls->numMethods = opt->methods;
+    cls->methods = malloc(sizeof(GenMethod) * (opt->methods + 1));
+    for (int k = 0; k < opt->methods; k++) {
+      GenMethod *m = &cls->methods[k];
+      GenClass *owner = &classes[randomAncestor(cls->superclass)];
+      GenMethod *inherited = cls->superclass > 0 && owner->numMethods > 0
+        ? &owner->methods[randomBelow(owner->numMethods)] : NULL;
+      int taken = inherited == NULL;
+      for (int j = 0; j < k && !taken; j++)
+        taken = strcmp(cls->methods[j].name, inherited->name) == 0;
+      /* the nearest version of the method must not be final */
+      for (int c = cls->superclass; c > 0 && !taken; c = classes[c].superclass) {
+        int j = 0;
+        while (j < classes[c].numMethods && strcmp(classes[c].methods[j].name, inherited->name) != 0) j++;
+        if (j < classes[c].numMethods) {
+          taken = classes[c].methods[j].isFinal;
+          break;
+        }
+      }
+      if (!taken && randomBelow(3) == 0) {
+        *m = *inherited;  /* override it, keeping its signature */
+      } else {
+        sprintf(m->name, "m%d_%d", i, k);
+        m->returnType = randomClass();
+        m->paramType = randomClass();
+      }
+      m->isFinal = randomBelow(8) == 0;
+    }
+  }
+  /* only classes nobody extends may be final */
+  for (int i = 1; i <= opt->numClasses; i++) classes[i].isFinal = randomBelow(4) == 0;
+  for (int i = 1; i <= opt->numClasses; i++) classes[classes[i].superclass].isFinal = 0;
+}
+
+static ASTree *genMethod(int cls, GenMethod *m) {
+  char text[160];
+  ASTree *method = node(m->isFinal ? FINAL_METHOD_DECL : NONFINAL_METHOD_DECL,
+                        idNode(m->name), idNode(typeName(m->returnType)), NULL);
+  appendToChildrenList(method, varDecl("p", m->paramType));
+  sprintf(text, "  %s%s %s(", m->isFinal ? "final " : "", typeName(m->returnType), m->name);
+  emit(text);
+  sprintf(text, "%s p) {\n", typeName(m->paramType));
+  emit(text);
+
+  /* local v0 holds the result; the body starts by assigning it and
+     ends by reading it */
+  GenVar locals[3];
+  int numLocals = 1 + randomBelow(3);
+  ASTree *localList = NULL;
+  for (int k = 0; k < numLocals; k++) {
+    sprintf(locals[k].name, "v%d", k);
+    locals[k].type = k == 0 ? m->returnType : randomClass();
+    sprintf(text, "    %s %s;\n", typeName(locals[k].type), locals[k].name);
+    appendOrStart(&localList, VAR_DECL_LIST, varDecl(locals[k].name, locals[k].type));
+    emit(text);
+  }
+  appendToChildrenList(method, localList);
+
+  GenScope s = { cls, m->paramType, locals, numLocals };
+  ASTree *body = NULL;
+  appendOrStart(&body, EXPR_LIST, statement(node(ASSIGN_EXPR, idNode("v0"),
+                genExpr(m->returnType, 1, &s, 0), NULL), "    "));
+  for (int k = randomBelow(3); k > 0; k--) {
+    int type = randomBelow(3) == 0 ? NAT : randomClass();
+    appendToChildrenList(body, statement(genExpr(type, 0, &s, 0), "    "));
+  }
+  appendToChildrenList(body, statement(node(ID_EXPR, idNode("v0"), NULL, NULL), "    "));
+  appendToChildrenList(method, body);
+  emit("  }\n");
+  return method;
+}
+
+static ASTree *genClass(int i) {
+  GenClass *cls = &classes[i];
+  char text[160];
+  ASTree *name = idNode(typeName(i));
+  ASTree *decl = node(cls->isFinal ? FINAL_CLASS_DECL : NONFINAL_CLASS_DECL,
+                      name, idNode(typeName(cls->superclass)), NULL);
+  sprintf(text, "%sclass C%d extends ", cls->isFinal ? "final " : "", i);
+  emit(text);
+  emit(typeName(cls->superclass));
+  emit(" {\n");
+
+  ASTree *fields = emptyList(VAR_DECL_LIST);
+  for (int k = 0; k < cls->numFields; k++) {
+    sprintf(text, "  %s %s;\n", typeName(cls->fields[k].type), cls->fields[k].name);
+    appendOrStart(&fields, VAR_DECL_LIST, varDecl(cls->fields[k].name, cls->fields[k].type));
+    emit(text);
+  }
+  ASTree *methods = emptyList(METHOD_DECL_LIST);
+  for (int k = 0; k < cls->numMethods; k++)
+    appendOrStart(&methods, METHOD_DECL_LIST, genMethod(i, &cls->methods[k]));
+  appendToChildrenList(decl, node(EXPR_LIST, fields, methods, NULL));
+  emit("}\n");
+  return decl;
+}
+
+void defaultGenOptions(GenOptions *opts) {
+  opts->seed = 1;
+  opts->numClasses = 100;
+  opts->maxDepth = 5;
+  opts->methods = 4;
+  opts->fields = 3;
+  opts->exprDepth = 4;
+  opts->mainLength = 20;
+}
+
+ASTree *generateProgram(const GenOptions *opts, FILE *source) {
+  opt = opts;
+  out = source;
+  line = 1;
+  rngState = 0x9E3779B97F4A7C15ULL ^ opts->seed;
+  if (rngState == 0) rngState = 1;
+  classes = calloc(opts->numClasses + 1, sizeof(GenClass));
+  if (classes == NULL) {
+    printf("ERROR: calloc failed in generateProgram()\n");
+    exit(-1);
+  }
+  planClasses();
+
+  ASTree *classList = emptyList(CLASS_DECL_LIST);
+  for (int i = 1; i <= opts->numClasses; i++)
+    appendOrStart(&classList, CLASS_DECL_LIST, genClass(i));
+
+  emit("main {\n");
+  GenVar locals[4];
+  ASTree *localList = NULL;
+  for (int k = 0; k < 4; k++) {
+    char text[160];
+    sprintf(locals[k].name, "a%d", k);
+    locals[k].type = randomClass();
+    sprintf(text, "  %s %s;\n", typeName(locals[k].type), locals[k].name);
+    appendOrStart(&localList, VAR_DECL_LIST, varDecl(locals[k].name, locals[k].type));
+    emit(text);
+  }
+  GenScope s = { -1, 0, locals, 4 };
+  ASTree *mainExprs = NULL;
+  for (int k = 0; k < opts->mainLength || k == 0; k++) {
+    int type = randomBelow(3) == 0 ? NAT : randomClass();
+    appendOrStart(&mainExprs, EXPR_LIST, statement(genExpr(type, 0, &s, 0), "  "));
+  }
+  emit("}\n");
+
+  for (int i = 1; i <= opts->numClasses; i++) {
+    free(classes[i].fields);
+    free(classes[i].methods);
+  }
+  free(classes);
+  return node(PROGRAM, classList, localList, mainExprs);
+}
@@ -0,0 +1,32 @@
+/* File generate.h: synthetic DJ programs, for benchmarking the compiler */
+
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/* The shape of a generated program */
+typedef struct {
+  unsigned int seed;   /* the same options and seed give the same program */
+  int numClasses;      /* user-defined classes */
+  int maxDepth;        /* longest superclass chain below Object (>= 1) */
+  int methods;         /* methods per class */
+  int fields;          /* fields per class */
+  int exprDepth;       /* how deeply expressions nest (>= 1) */
+  int mainLength;      /* expressions in the main block */
+} GenOptions;
+
+/* Fill opts with the defaults gendj and benchdj start from */
+void defaultGenOptions(GenOptions *opts);
+
+/* Generate a well-typed DJ program of the given shape.  Its source text
+   is written to source (unless source is NULL), and its AST is
+   returned in the form the parser builds and setupSymbolTables()
+   expects, with line numbers matching the text.  Every variable has a
+   class type; methods override inherited ones (with the same
+   signature) about a third of the time, and a few methods and leaf
+   classes are final. */
+ASTree *generateProgram(const GenOptions *opts, FILE *source);
+
+#endif
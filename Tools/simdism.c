@@ -0,0 +1,253 @@
+/* File simdism.c: run DISM programs, counting the instructions executed
+
+   Runs each program named on the command line in turn, reading any
+   rdn input from stdin and printing each ptn value on a line of its
+   own, then reports how the program stopped and how many instructions
+   it executed, so the code generator's output (and the peephole
+   optimizer's effect on it, see peephole.h) can be measured.
+   Build with
+     gcc -O2 Tools/simdism.c -o simdism
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MEMORY_WORDS 65536
+#define MAX_LINE 4096
+
+enum { MOV, ADD, SUB, MUL, JMP, BEQ, BLT, LOD, STR, RDN, PTN, HLT, NUM_OPS };
+static const char *opNames[NUM_OPS] = {
+  "mov", "add", "sub", "mul", "jmp", "beq", "blt",
+  "lod", "str", "rdn", "ptn", "hlt"
+};
+/* operands of each op, and which of them (as bits) are registers; the
+   others are numbers, or labels for mov, jmp, beq and blt */
+static const int numOperands[NUM_OPS] = { 2, 3, 3, 3, 2, 3, 3, 3, 3, 1, 1, 1 };
+static const int registerOperands[NUM_OPS] = { 1, 7, 7, 7, 1, 3, 3, 3, 5, 1, 1, 1 };
+
+/* how a run ended */
+enum { HALTED, FAILED, STOPPED };
+
+typedef struct {
+  int op;
+  int arg[3];
+  int line;
+} Instr;
+
+/* A program; labels are kept in an open-addressed hash table */
+typedef struct {
+  Instr *code;
+  int length;
+  char **labelNames;
+  int *labelAddrs;
+  unsigned int labelMask;
+} Program;
+
+static void fail(char *path, int line, char *msg) {
+  printf("ERROR: %s, line %d: %s\n", path, line, msg);
+  exit(-1);
+}
+
+static unsigned int hashName(const char *s, size_t n) {
+  unsigned int h = 2166136261u;
+  for (size_t i = 0; i < n; i++) h = (h ^ (unsigned char)s[i]) * 16777619u;
+  return h;
+}
+
+/* slot of the label named by the n characters at s */
+static unsigned int labelSlot(Program *p, const char *s, size_t n) {
+  unsigned int h = hashName(s, n) & p->labelMask;
+  while (p->labelNames[h] != NULL
+         && (strlen(p->labelNames[h]) != n || strncmp(p->labelNames[h], s, n) != 0))
+    h = (h + 1) & p->labelMask;
+  return h;
+}
+
+/* skip spaces; returns the first other character */
+static char *skipSpace(char *s) {
+  while (*s == ' ' || *s == '\t' || *s == '\r') s++;
+  return s;
+}
+
+/* the length of the label name at s (after its '#') */
+static size_t nameLength(const char *s) {
+  size_t n = 0;
+  while (isalnum((unsigned char)s[n]) || s[n] == '_') n++;
+  return n;
+}
+
+/* Load the program in file path, in two passes: one to find the
+   labels, one to read the instructions */
+static void loadProgram(char *path, Program *p) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    printf("ERROR: could not open file %s\n", path);
+    exit(-1);
+  }
+  char text[MAX_LINE];
+  int numLines = 0;
+  while (fgets(text, sizeof text, f) != NULL) numLines++;
+  unsigned int size = 16;
+  while (size < 2 * (unsigned int)numLines) size *= 2;
+  p->labelNames = calloc(size, sizeof(char *));
+  p->labelAddrs = malloc(size * sizeof(int));
+  p->code = malloc((numLines + 1) * sizeof(Instr));
+  if (p->labelNames == NULL || p->labelAddrs == NULL || p->code == NULL) {
+    printf("ERROR: malloc failed in loadProgram()\n");
+    exit(-1);
+  }
+  p->labelMask = size - 1;
+  for (int pass = 0; pass < 2; pass++) {
+    rewind(f);
+    p->length = 0;
+    for (int line = 1; fgets(text, sizeof text, f) != NULL; line++) {
+      char *semi = strchr(text, ';');
+      if (semi != NULL) *semi = '\0';
+      char *s = skipSpace(text);
+      if (*s == '#') {
+        size_t n = nameLength(s + 1);
+        char *colon = skipSpace(s + 1 + n);
+        if (*colon != ':') fail(path, line, "expected ':' after a label");
+        if (pass == 0) {
+          unsigned int h = labelSlot(p, s + 1, n);
+          if (p->labelNames[h] != NULL) fail(path, line, "label defined twice");
+          p->labelNames[h] = strndup(s + 1, n);
+          p->labelAddrs[h] = p->length;
+        }
+        s = skipSpace(colon + 1);
+      }
+      if (*s == '\n' || *s == '\0') continue;
+      Instr *in = &p->code[p->length++];
+      in->line = line;
+      for (in->op = 0; in->op < NUM_OPS; in->op++)
+        if (strncmp(s, opNames[in->op], 3) == 0 && !isalnum((unsigned char)s[3])) break;
+      if (in->op == NUM_OPS) fail(path, line, "unknown instruction");
+      s += 3;
+      for (int a = 0; a < numOperands[in->op]; a++) {
+        s = skipSpace(s);
+        if (*s == '#') {
+          size_t n = nameLength(s + 1);
+          if (registerOperands[in->op] >> a & 1) fail(path, line, "expected a register");
+          if (pass == 1) {
+            unsigned int h = labelSlot(p, s + 1, n);
+            if (p->labelNames[h] == NULL) fail(path, line, "undefined label");
+            in->arg[a] = p->labelAddrs[h];
+          }
+          s += 1 + n;
+        } else {
+          char *end;
+          in->arg[a] = (int)strtol(s, &end, 10);
+          if (end == s) fail(path, line, "expected a number or label");
+          s = end;
+        }
+        if ((registerOperands[in->op] >> a & 1) && (in->arg[a] < 0 || in->arg[a] > 7))
+          fail(path, line, "expected a register, 0 to 7");
+      }
+      s = skipSpace(s);
+      if (*s != '\n' && *s != '\0') fail(path, line, "unexpected text after instruction");
+    }
+  }
+  fclose(f);
+}
+
+static void freeProgram(Program *p) {
+  for (unsigned int h = 0; h <= p->labelMask; h++) free(p->labelNames[h]);
+  free(p->labelNames);
+  free(p->labelAddrs);
+  free(p->code);
+}
+
+/* Run p, counting the instructions executed in *executed and of each
+   op in opCounts.  Returns HALTED (setting *status to the halt status),
+   FAILED if the program went wrong (after printing why), or STOPPED if
+   it ran limit instructions without halting. */
+static int run(char *path, Program *p, long limit, long *executed, long *opCounts,
+               int *status) {
+  static int memory[MEMORY_WORDS];
+  int r[8] = { 0 };
+  int pc = 0;
+  memset(memory, 0, sizeof memory);
+  for (*executed = 0; ; ) {
+    if (pc < 0 || pc >= p->length) {
+      printf("%s: jump to address %d, outside the program\n", path, pc);
+      return FAILED;
+    }
+    if (*executed == limit) return STOPPED;
+    Instr *in = &p->code[pc++];
+    int *a = in->arg;
+    int address;
+    (*executed)++;
+    opCounts[in->op]++;
+    switch (in->op) {
+    case MOV: r[a[0]] = a[1]; break;
+    case ADD: r[a[0]] = r[a[1]] + r[a[2]]; break;
+    case SUB: r[a[0]] = r[a[1]] - r[a[2]]; break;
+    case MUL: r[a[0]] = r[a[1]] * r[a[2]]; break;
+    case JMP: pc = r[a[0]] + a[1]; break;
+    case BEQ: if (r[a[0]] == r[a[1]]) pc = a[2]; break;
+    case BLT: if (r[a[0]] < r[a[1]]) pc = a[2]; break;
+    case LOD:
+    case STR:
+      address = in->op == LOD ? r[a[1]] + a[2] : r[a[0]] + a[1];
+      if (address < 0 || address >= MEMORY_WORDS) {
+        printf("%s: line %d: address %d is out of range\n", path, in->line, address);
+        return FAILED;
+      }
+      if (in->op == LOD) r[a[0]] = memory[address];
+      else memory[address] = r[a[2]];
+      break;
+    case RDN:
+      if (scanf("%d", &r[a[0]]) != 1) {
+        printf("%s: line %d: no number to read\n", path, in->line);
+        return FAILED;
+      }
+      break;
+    case PTN: printf("%d\n", r[a[0]]); break;
+    case HLT:
+      *status = r[a[0]];
+      return HALTED;
+    }
+    r[0] = 0;
+  }
+}
+
+int main(int argc, char **argv) {
+  /* Options:
+     -limit N   stop a program after N instructions (default 10^9)
+     -ops       also report how often each instruction was executed */
+  long limit = 1000000000L;
+  int showOps = 0;
+  int arg = 1;
+  while (arg < argc && argv[arg][0] == '-') {
+    if (strcmp(argv[arg], "-limit") == 0 && arg + 1 < argc) limit = atol(argv[++arg]);
+    else if (strcmp(argv[arg], "-ops") == 0) showOps = 1;
+    else break;
+    arg++;
+  }
+  if (arg >= argc || limit < 1) {
+    printf("Usage: simdism [-limit N] [-ops] prog.dism...\n");
+    exit(-1);
+  }
+  int failures = 0;
+  for (; arg < argc; arg++) {
+    Program p;
+    long opCounts[NUM_OPS] = { 0 };
+    long executed;
+    int status;
+    loadProgram(argv[arg], &p);
+    int outcome = run(argv[arg], &p, limit, &executed, opCounts, &status);
+    if (outcome == STOPPED) printf("%s: stopped", argv[arg]);
+    else if (outcome == FAILED) printf("%s: failed", argv[arg]);
+    else printf("%s: halted with status %d", argv[arg], status);
+    printf(" after %ld instructions (%d in the program)\n", executed, p.length);
+    if (showOps) {
+      for (int op = 0; op < NUM_OPS; op++)
+        if (opCounts[op] > 0) printf("  %s %ld\n", opNames[op], opCounts[op]);
+    }
+    if (outcome != HALTED) failures++;
+    freeProgram(&p);
+  }
+  return failures;
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+# File stacklimit.sh: check that new objects stay below every stack frame
+#
+# A method called from a shallow point of main fills the heap up to the
+# stack limit, and then main evaluates an expression nested DEPTH deep,
+# pushing its temporaries below the method's old frame.  Unless the
+# heap check in new counts main's deepest stack use (STACK_LIMIT, see
+# symtbl.h), those temporaries overwrite the new objects, and the
+# list walk's assert fails or the program stops early.  The program
+# must halt with status 77 (out of memory) before the list is touched,
+# with no output.
+# Usage: sh Tools/stacklimit.sh [DJC [SIMDISM [DEPTH [OBJECTS]]]]
+# (defaults ./djc, ./simdism, 2000 and 21500; OBJECTS fills the heap to
+# within DEPTH words of the method's frame)
+
+djc=${1:-./djc}
+simdism=${2:-./simdism}
+depth=${3:-2000}
+objects=${4:-21500}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+deep="readNat()"
+i=0
+while [ $i -lt "$depth" ]; do
+  deep="readNat() + ($deep)"
+  i=$((i + 1))
+done
+cat > "$dir/stacklimit.dj" <<EOF
+class Node extends Object {
+  Node next;
+  Node self;
+  Node grow(Node list) {
+    Node n;
+    while (0 < readNat()) { n = new Node(); n.self = n; n.next = list; list = n; };
+    list;
+  }
+}
+main {
+  Node list;
+  list = new Node().grow(null);
+  printNat($deep);
+  while (!(list == null)) { assert list.self == list; list = list.next; };
+  printNat(1);
+}
+EOF
+
+"$djc" "$dir/stacklimit.dj" > /dev/null || exit 1
+result=$( { yes 1 | head -n "$objects"; echo 0; yes 0 | head -n $((depth + 1)); } |
+          "$simdism" "$dir/stacklimit.dism")
+echo "$result"
+case "$result" in
+  *"halted with status 77"*) echo "PASS" ;;
+  *) echo "FAIL: expected halt 77 before main's deep expression"; exit 1 ;;
+esac
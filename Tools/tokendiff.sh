@@ -0,0 +1,68 @@
+#!/bin/sh
+# File tokendiff.sh: check that the two scanners produce the same tokens
+#
+# Runs "parsedj -tokens" built with the flex scanner (dj.l) and with the
+# hand-written one (-DHANDSCAN, djscan.c) over generated programs, a
+# file of lexical corner cases and any FILEs given, each read both
+# through yyin and through -mmap, and reports every file whose token
+# streams (line, token and text, or the lex error) differ.
+# Usage: sh Tools/tokendiff.sh FLEX_PARSEDJ HAND_PARSEDJ [GENDJ [FILE...]]
+# (GENDJ defaults to ./gendj; the exit status is the number of
+# mismatching files)
+
+if [ $# -lt 2 ]; then
+  echo "Usage: sh Tools/tokendiff.sh FLEX_PARSEDJ HAND_PARSEDJ [GENDJ [FILE...]]"
+  exit 1
+fi
+flex=$1
+hand=$2
+gendj=${3:-./gendj}
+[ $# -ge 3 ] && shift 3 || shift $#
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# generated programs of several shapes
+seed=1
+for shape in "-classes 4 -nesting 2" "-classes 40 -nesting 4" \
+             "-classes 200 -depth 12 -methods 6 -nesting 6 -main 80"; do
+  for i in 1 2 3 4 5; do
+    "$gendj" -seed $seed $shape "$dir/gen$seed.dj" > /dev/null || exit 1
+    seed=$((seed + 1))
+  done
+done
+
+# keywords as prefixes of names, adjacent tokens, comments, CR LF and
+# tab whitespace, long numbers and names, and no newline at the end
+{
+  printf 'class classy extends Object { nat final_; nat nat0; }\r\n'
+  printf 'final class _C extends classy {}  // comment with "quotes" and ||\n'
+  printf 'main {\n'
+  printf '  nat x;\tnat y2; classy c;\n'
+  printf '  x=00+12345678901234567890*y2-0;x==1||!(x<2);\n'
+  printf '  c=new classy();c.final_=this.nat0;assert null==null;\n'
+  printf '  if(x<1){printNat(readNat());}else{while(0<x){x=x-1;};};\n'
+  printf '  aVeryLongNameThatKeepsGoingPastEightBytesAtATime123;\n'
+  printf '//\n'
+  printf '}'
+} > "$dir/corners.dj"
+# a lex error, after some tokens on a later line
+printf 'main {\n  1 + 2;\n  3 | 4;\n}\n' > "$dir/lexerror.dj"
+# an empty file
+: > "$dir/empty.dj"
+
+bad=0
+for f in "$dir"/*.dj "$@"; do
+  "$flex" -tokens "$f" > "$dir/flex" 2>&1
+  "$flex" -mmap -tokens "$f" > "$dir/flexmmap" 2>&1
+  "$hand" -tokens "$f" > "$dir/hand" 2>&1
+  "$hand" -mmap -tokens "$f" > "$dir/handmmap" 2>&1
+  for out in flexmmap hand handmmap; do
+    if ! cmp -s "$dir/flex" "$dir/$out"; then
+      echo "MISMATCH: $(basename "$f") ($out differs from flex through yyin)"
+      bad=$((bad + 1))
+      break
+    fi
+  done
+done
+echo "$bad mismatching files"
+exit $bad
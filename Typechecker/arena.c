@@ -0,0 +1,76 @@
+/* File arena.c
+   Implementation of phase-scoped bump-pointer arenas
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdalign.h>
+#include <sys/resource.h>
+#include "arena.h"
+
+#define ARENA_BLOCK_SIZE (256 * 1024)
+#define ARENA_ALIGN alignof(max_align_t)
+
+_Thread_local Arena astArena = { .name = "ast" };
+_Thread_local Arena symtblArena = { .name = "symtbl" };
+
+static size_t roundUp(size_t n) {
+  return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/* Start a new block big enough for at least size bytes */
+static void newBlock(Arena *a, size_t size) {
+  size_t usable = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+  ArenaBlock *b = malloc(roundUp(sizeof(ArenaBlock)) + usable);
+  if (b == NULL) {
+    printf("Arena Error: malloc failed for arena %s\n", a->name);
+    exit(-1);
+  }
+  b->next = a->blocks;
+  b->size = usable;
+  a->blocks = b;
+  a->next = (char *)b + roundUp(sizeof(ArenaBlock));
+  a->left = usable;
+  a->bytesReserved += usable;
+  if (a->bytesReserved > a->peakReserved) a->peakReserved = a->bytesReserved;
+}
+
+void *arenaAlloc(Arena *a, size_t size) {
+  size = roundUp(size ? size : 1);
+  if (size > a->left) newBlock(a, size);
+  void *p = a->next;
+  a->next += size;
+  a->left -= size;
+  a->numAllocs++;
+  a->bytesAllocated += size;
+  return p;
+}
+
+void arenaRelease(Arena *a) {
+  ArenaBlock *b = a->blocks;
+  while (b != NULL) {
+    ArenaBlock *next = b->next;
+    free(b);
+    b = next;
+  }
+  a->blocks = NULL;
+  a->next = NULL;
+  a->left = 0;
+  a->numAllocs = 0;
+  a->bytesAllocated = 0;
+  a->bytesReserved = 0;
+}
+
+static void printArenaStats(FILE *out, Arena *a) {
+  fprintf(out, "  arena %-8s %10lu allocations %12zu bytes used %12zu bytes peak\n",
+          a->name, a->numAllocs, a->bytesAllocated, a->peakReserved);
+}
+
+void printMemoryStats(FILE *out) {
+  struct rusage usage;
+  fprintf(out, "Memory statistics:\n");
+  printArenaStats(out, &astArena);
+  printArenaStats(out, &symtblArena);
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    fprintf(out, "  peak RSS %ld KB\n", usage.ru_maxrss);
+}
@@ -1,149 +1,455 @@
-/* File ast.c
-   Implementation of DJ ASTs
-*/
-
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-#include "ast.h"
-
-void printError(char *reason) {
-  printf("AST Error: %s\n", reason);
-  exit(-1);
-}
-
-/* Create a new AST node of type t */
-ASTree *newAST(ASTNodeType t, ASTree *child, unsigned int natAttribute, 
-  char *idAttribute, unsigned int lineNum) {
-  ASTree *toReturn = malloc(sizeof(ASTree));
-  if(toReturn == NULL) printError("malloc in newAST()");
-  toReturn->typ = t;
-  // create a linked list of children
-  ASTList *childList = malloc(sizeof(ASTList));
-  if (childList == NULL) {
-      printf("AST Error: malloc failed in newAST()\n");
-      exit(-1);
-  }
-  childList->data = child;
-  childList->next = NULL;
-
-  toReturn->children = childList;
-  toReturn->childrenTail = childList;
-
-  // Set node attributes
-  if (t == NAT_LITERAL_EXPR) {
-      toReturn->natVal = natAttribute;
-      toReturn->idVal = NULL;
-  } else if (t == AST_ID) {
-      if (idAttribute != NULL) {
-          toReturn->idVal = malloc(strlen(idAttribute) + 1);
-          if (toReturn->idVal == NULL) {
-              printf("AST Error: malloc failed in newAST()\n");
-              exit(-1);
-          }
-          strcpy(toReturn->idVal, idAttribute);
-      } else {
-          toReturn->idVal = NULL;
-      }
-      toReturn->natVal = 0;
-  } else {
-      toReturn->natVal = 0;
-      toReturn->idVal = NULL;
-  }
-
-  // Initialize static type-checking attributes
-  toReturn->staticClassNum = 0;
-  toReturn->staticMemberNum = 0;
-
-  // Store line number
-  toReturn->lineNumber = lineNum;
-  return toReturn;
-}
-
-/* Append a new child AST node onto a parent's list of children */
-void appendToChildrenList(ASTree *parent, ASTree *newChild) {
-    if (parent == NULL) printError("append called with null parent");
-    if (parent->children == NULL || parent->childrenTail == NULL)
-      printError("append called with bad parent");
-    if (newChild == NULL) printError("append called with null newChild");
-
-    if (parent->childrenTail->data == NULL) {  // Replace empty tail with new child
-      parent->childrenTail->data = newChild;
-    } else {  // Append new child to list
-      ASTList *newList = malloc(sizeof(ASTList));
-      if (newList == NULL) printError("malloc in appendToChildrenList()");
-      newList->data = newChild;
-      newList->next = NULL;
-      parent->childrenTail->next = newList;
-      parent->childrenTail = newList;
-    }
-}
-
-/* Print the type of this node and any node attributes */
-void printNodeTypeAndAttribute(ASTree *t) {
-  if (t == NULL) return;
-  
-  switch (t->typ) {
-    case PROGRAM: printf("PROGRAM"); break;
-    case CLASS_DECL_LIST: printf("CLASS_DECL_LIST"); break;
-    case FINAL_CLASS_DECL: printf("FINAL_CLASS_DECL"); break;
-    case NONFINAL_CLASS_DECL: printf("NONFINAL_CLASS_DECL"); break;
-    case VAR_DECL_LIST: printf("VAR_DECL_LIST"); break;
-    case VAR_DECL: printf("VAR_DECL"); break;
-    case METHOD_DECL_LIST: printf("METHOD_DECL_LIST"); break;
-    case FINAL_METHOD_DECL: printf("FINAL_METHOD_DECL"); break;
-    case NONFINAL_METHOD_DECL: printf("NONFINAL_METHOD_DECL"); break;
-
-    /* types, including generic IDs */
-    case NAT_TYPE: printf("NAT_TYPE"); break;
-    case AST_ID: printf("AST_ID(%s)", t->idAttribute); break;
-
-    /* expression-lists */
-    case EXPR_LIST: printf("EXPR_LIST"); break;
-
-    /* expressions */
-    case DOT_METHOD_CALL_EXPR: printf("DOT_METHOD_CALL_EXPR"); break;
-    case METHOD_CALL_EXPR: printf("METHOD_CALL_EXPR"); break;
-    case DOT_ID_EXPR: printf("DOT_ID_EXPR"); break;
-    case ID_EXPR: printf("ID_EXPR"); break;
-    case DOT_ASSIGN_EXPR: printf("DOT_ASSIGN_EXPR"); break;
-    case ASSIGN_EXPR: printf("ASSIGN_EXPR"); break;
-    case PLUS_EXPR: printf("PLUS_EXPR"); break;
-    case MINUS_EXPR: printf("MINUS_EXPR"); break;
-    case TIMES_EXPR: printf("TIMES_EXPR"); break;
-    case EQUALITY_EXPR: printf("EQUALITY_EXPR"); break;
-    case LESS_THAN_EXPR: printf("LESS_THAN_EXPR"); break;
-    case NOT_EXPR: printf("NOT_EXPR"); break;
-    case OR_EXPR: printf("OR_EXPR"); break;
-    case ASSERT_EXPR: printf("ASSERT_EXPR"); break;
-    case IF_THEN_ELSE_EXPR: printf("IF_THEN_ELSE_EXPR"); break;
-    case WHILE_EXPR: printf("WHILE_EXPR"); break;
-    case PRINT_EXPR: printf("PRINT_EXPR"); break;
-    case READ_EXPR: printf("READ_EXPR"); break;
-    case THIS_EXPR: printf("THIS_EXPR"); break;
-    case NEW_EXPR: printf("NEW_EXPR"); break;
-    case NULL_EXPR: printf("NULL_EXPR"); break;
-    case NAT_LITERAL_EXPR: printf("NAT_LITERAL_EXPR(%u)", t->natAttribute); break;
-
-    default:
-      printError("unknown node type in printNodeTypeAndAttribute()");
-  }
-}
-
-/* Print tree in preorder */
-void printASTree(ASTree *t, int depth) {
-  if (t == NULL) return;
-  printf("%d:", depth);
-  for (int i = 0; i < depth; i++) printf("  ");
-  printNodeTypeAndAttribute(t);
-  printf("\n");
-  
-  ASTList *childListIterator = t->children;
-  while (childListIterator != NULL) {
-    printASTree(childListIterator->data, depth + 1);
-    childListIterator = childListIterator->next;
-  }
-}
-
-/* Print the AST to stdout with indentations marking tree depth. */
-void printAST(ASTree *t) { printASTree(t, 0); }
+/* File ast.c
+   Implementation of DJ ASTs
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ast.h"
+#include "intern.h"
+#include "arena.h"
+#include "recover.h"
+#include "timing.h"
+
+void printError(char *reason) {
+  printf("AST Error: %s\n", reason);
+  compileFailed(-1);
+}
+
+/* Create a new AST node of type t */
+ASTree *newAST(ASTNodeType t, ASTree *child, unsigned int natAttribute, 
+  char *idAttribute, unsigned int lineNum) {
+  ASTree *toReturn = arenaAlloc(&astArena, sizeof(ASTree));
+  toReturn->typ = t;
+  timedNodes++;
+  // create a linked list of children
+  ASTList *childList = arenaAlloc(&astArena, sizeof(ASTList));
+  childList->data = child;
+  childList->next = NULL;
+
+  toReturn->children = childList;
+  toReturn->childrenTail = childList;
+
+  // Set node attributes
+  if (t == NAT_LITERAL_EXPR) {
+      toReturn->natVal = natAttribute;
+      toReturn->idVal = NULL;
+      toReturn->idNum = -1;
+  } else if (t == AST_ID) {
+      if (idAttribute != NULL) {
+          toReturn->idNum = internName(idAttribute, strlen(idAttribute));
+          toReturn->idVal = nameText(toReturn->idNum);
+      } else {
+          toReturn->idNum = -1;
+          toReturn->idVal = NULL;
+      }
+      toReturn->natVal = 0;
+  } else {
+      toReturn->natVal = 0;
+      toReturn->idVal = NULL;
+      toReturn->idNum = -1;
+  }
+
+  // Initialize static type-checking attributes
+  toReturn->staticClassNum = 0;
+  toReturn->staticMemberNum = 0;
+  toReturn->staticType = -3;
+  toReturn->varKind = VAR_UNRESOLVED;
+  toReturn->varOffset = 0;
+
+  // Store line number
+  toReturn->lineNumber = lineNum;
+  return toReturn;
+}
+
+/* Append a new child AST node onto a parent's list of children */
+void appendToChildrenList(ASTree *parent, ASTree *newChild) {
+    if (parent == NULL) printError("append called with null parent");
+    if (parent->children == NULL || parent->childrenTail == NULL)
+      printError("append called with bad parent");
+    if (newChild == NULL) printError("append called with null newChild");
+
+    if (parent->childrenTail->data == NULL) {  // Replace empty tail with new child
+      parent->childrenTail->data = newChild;
+    } else {  // Append new child to list
+      ASTList *newList = arenaAlloc(&astArena, sizeof(ASTList));
+      newList->data = newChild;
+      newList->next = NULL;
+      parent->childrenTail->next = newList;
+      parent->childrenTail = newList;
+    }
+}
+
+/* Create a compact copy of the tree (see ast.h) */
+ASTree *compactAST(ASTree *t) {
+  if (t == NULL) return NULL;
+  /* the copy keeps the original's peak, and its allocations add to the
+     original's counts, so the counts never go backwards within a
+     compile (see timing.h) */
+  Arena compacted = { .name = astArena.name,
+                      .numAllocs = astArena.numAllocs,
+                      .bytesAllocated = astArena.bytesAllocated,
+                      .peakReserved = astArena.peakReserved };
+
+  /* explicit stack of (original node, cell that must point at its copy),
+     so deep left-recursive lists don't exhaust the C stack */
+  size_t stackSize = 64, top = 0;
+  ASTree **pending = malloc(sizeof(ASTree *) * stackSize);
+  ASTList **dest = malloc(sizeof(ASTList *) * stackSize);
+  if (pending == NULL || dest == NULL) printError("malloc in compactAST()");
+  ASTree *root = NULL;
+  pending[top] = t;
+  dest[top] = NULL;
+  top++;
+
+  while (top > 0) {
+    top--;
+    ASTree *orig = pending[top];
+    ASTList *into = dest[top];
+    ASTree *copy = arenaAlloc(&compacted, sizeof(ASTree));
+    *copy = *orig;
+    if (into != NULL) into->data = copy;
+    else root = copy;
+
+    /* lay this node's child cells out side by side */
+    int m = 0, nonNull = 0;
+    for (ASTList *cell = orig->children; cell != NULL; cell = cell->next) {
+      m++;
+      if (cell->data != NULL) nonNull++;
+    }
+    if (m == 0) continue;
+    ASTList *cells = arenaAlloc(&compacted, sizeof(ASTList) * m);
+    copy->children = cells;
+    copy->childrenTail = &cells[m - 1];
+
+    /* queue the children last-first so they are copied in preorder */
+    if (top + nonNull > stackSize) {
+      while (top + nonNull > stackSize) stackSize *= 2;
+      pending = realloc(pending, sizeof(ASTree *) * stackSize);
+      dest = realloc(dest, sizeof(ASTList *) * stackSize);
+      if (pending == NULL || dest == NULL) printError("realloc in compactAST()");
+    }
+    int i = 0, j = 0;
+    for (ASTList *cell = orig->children; cell != NULL; cell = cell->next, i++) {
+      cells[i].data = NULL;
+      cells[i].next = (i + 1 < m) ? &cells[i + 1] : NULL;
+      if (cell->data != NULL) {
+        pending[top + nonNull - 1 - j] = cell->data;
+        dest[top + nonNull - 1 - j] = &cells[i];
+        j++;
+      }
+    }
+    top += nonNull;
+  }
+  free(pending);
+  free(dest);
+
+  /* both trees are held until now */
+  size_t both = astArena.bytesReserved + compacted.bytesReserved;
+  if (both > compacted.peakReserved) compacted.peakReserved = both;
+  arenaRelease(&astArena);
+  astArena = compacted;
+  return root;
+}
+
+/* Print the type of this node and any node attributes */
+void printNodeTypeAndAttribute(ASTree *t) {
+  if (t == NULL) return;
+  
+  switch (t->typ) {
+    case PROGRAM: printf("PROGRAM"); break;
+    case CLASS_DECL_LIST: printf("CLASS_DECL_LIST"); break;
+    case FINAL_CLASS_DECL: printf("FINAL_CLASS_DECL"); break;
+    case NONFINAL_CLASS_DECL: printf("NONFINAL_CLASS_DECL"); break;
+    case VAR_DECL_LIST: printf("VAR_DECL_LIST"); break;
+    case VAR_DECL: printf("VAR_DECL"); break;
+    case METHOD_DECL_LIST: printf("METHOD_DECL_LIST"); break;
+    case FINAL_METHOD_DECL: printf("FINAL_METHOD_DECL"); break;
+    case NONFINAL_METHOD_DECL: printf("NONFINAL_METHOD_DECL"); break;
+
+    /* types, including generic IDs */
+    case NAT_TYPE: printf("NAT_TYPE"); break;
+    case AST_ID: printf("AST_ID(%s)", t->idVal); break;
+
+    /* expression-lists */
+    case EXPR_LIST: printf("EXPR_LIST"); break;
+
+    /* expressions */
+    case DOT_METHOD_CALL_EXPR: printf("DOT_METHOD_CALL_EXPR"); break;
+    case METHOD_CALL_EXPR: printf("METHOD_CALL_EXPR"); break;
+    case DOT_ID_EXPR: printf("DOT_ID_EXPR"); break;
+    case ID_EXPR: printf("ID_EXPR"); break;
+    case DOT_ASSIGN_EXPR: printf("DOT_ASSIGN_EXPR"); break;
+    case ASSIGN_EXPR: printf("ASSIGN_EXPR"); break;
+    case PLUS_EXPR: printf("PLUS_EXPR"); break;
+    case MINUS_EXPR: printf("MINUS_EXPR"); break;
+    case TIMES_EXPR: printf("TIMES_EXPR"); break;
+    case EQUALITY_EXPR: printf("EQUALITY_EXPR"); break;
+    case LESS_THAN_EXPR: printf("LESS_THAN_EXPR"); break;
+    case NOT_EXPR: printf("NOT_EXPR"); break;
+    case OR_EXPR: printf("OR_EXPR"); break;
+    case ASSERT_EXPR: printf("ASSERT_EXPR"); break;
+    case IF_THEN_ELSE_EXPR: printf("IF_THEN_ELSE_EXPR"); break;
+    case WHILE_EXPR: printf("WHILE_EXPR"); break;
+    case PRINT_EXPR: printf("PRINT_EXPR"); break;
+    case READ_EXPR: printf("READ_EXPR"); break;
+    case THIS_EXPR: printf("THIS_EXPR"); break;
+    case NEW_EXPR: printf("NEW_EXPR"); break;
+    case NULL_EXPR: printf("NULL_EXPR"); break;
+    case NAT_LITERAL_EXPR: printf("NAT_LITERAL_EXPR(%u)", t->natVal); break;
+
+    default:
+      printError("unknown node type in printNodeTypeAndAttribute()");
+  }
+}
+
+/* Print tree in preorder */
+void printASTree(ASTree *t, int depth) {
+  if (t == NULL) return;
+  printf("%d:", depth);
+  for (int i = 0; i < depth; i++) printf("  ");
+  printNodeTypeAndAttribute(t);
+  printf("\n");
+  
+  ASTList *childListIterator = t->children;
+  while (childListIterator != NULL) {
+    printASTree(childListIterator->data, depth + 1);
+    childListIterator = childListIterator->next;
+  }
+}
+
+/* Print the AST to stdout with indentations marking tree depth. */
+void printAST(ASTree *t) { printASTree(t, 0); }
+
+/* .djast files (see ast.h): a DJASTHeader, the names' NUL-terminated
+   texts padded to a multiple of four bytes, then the DJASTRecords */
+#define DJAST_MAGIC 0x54534A44u   /* "DJST" in a little-endian word */
+#define DJAST_VERSION 2u
+#define DJAST_NO_NODE 0xFFFFFFFFu /* typ recorded for an empty child cell */
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numNames;
+  uint32_t nameBytes;   /* length of the texts, not counting padding */
+  uint32_t numRecords;
+} DJASTHeader;
+
+typedef struct {
+  uint32_t typ;         /* an ASTNodeType, or DJAST_NO_NODE */
+  uint32_t numCells;    /* cells in this node's list of children */
+  uint32_t lineNumber;
+  uint32_t natVal;
+  int32_t idNum;        /* index of the name in this file, or -1 */
+  uint32_t staticClassNum;
+  uint32_t staticMemberNum;
+  int32_t staticType;
+} DJASTRecord;
+
+/* Write a tree to a .djast file */
+int writeASTFile(ASTree *t, char *filename) {
+  FILE *out = fopen(filename, "wb");
+  if (out == NULL) {
+    printf("ERROR: could not open file %s\n", filename);
+    return 1;
+  }
+  DJASTHeader h = { DJAST_MAGIC, DJAST_VERSION, numNames(), 0, 0 };
+  fwrite(&h, sizeof h, 1, out);
+  for (int i = 0; i < numNames(); i++) {
+    char *text = nameText(i);
+    size_t len = strlen(text) + 1;
+    fwrite(text, 1, len, out);
+    h.nameBytes += len;
+  }
+  static const char padding[4];
+  fwrite(padding, 1, (4 - h.nameBytes % 4) % 4, out);
+
+  /* explicit preorder stack of nodes (NULL for an empty cell) */
+  size_t stackSize = 64, top = 0;
+  ASTree **pending = malloc(sizeof(ASTree *) * stackSize);
+  if (pending == NULL) printError("malloc in writeASTFile()");
+  pending[top++] = t;
+  while (top > 0) {
+    ASTree *n = pending[--top];
+    DJASTRecord r = { DJAST_NO_NODE, 0, 0, 0, -1, 0, 0, -3 };
+    if (n != NULL) {
+      r.typ = n->typ;
+      r.lineNumber = n->lineNumber;
+      r.natVal = n->natVal;
+      r.idNum = n->idNum;
+      r.staticClassNum = n->staticClassNum;
+      r.staticMemberNum = n->staticMemberNum;
+      r.staticType = n->staticType;
+      for (ASTList *cell = n->children; cell != NULL; cell = cell->next)
+        r.numCells++;
+    }
+    fwrite(&r, sizeof r, 1, out);
+    h.numRecords++;
+    if (r.numCells == 0) continue;
+
+    if (top + r.numCells > stackSize) {
+      while (top + r.numCells > stackSize) stackSize *= 2;
+      pending = realloc(pending, sizeof(ASTree *) * stackSize);
+      if (pending == NULL) printError("realloc in writeASTFile()");
+    }
+    int i = 0;
+    for (ASTList *cell = n->children; cell != NULL; cell = cell->next, i++)
+      pending[top + r.numCells - 1 - i] = cell->data;
+    top += r.numCells;
+  }
+  free(pending);
+
+  /* now that the counts are known, fill them in */
+  fseek(out, 0, SEEK_SET);
+  fwrite(&h, sizeof h, 1, out);
+  if (ferror(out) | fclose(out)) {
+    printf("ERROR: could not write file %s\n", filename);
+    return 1;
+  }
+  return 0;
+}
+
+/* Rebuild the tree from the records of a mapped .djast file whose
+   header h is valid, storing its root in *root.
+   nameNums maps the file's name indexes to interned numbers.
+   Returns NULL on success, or why the records are malformed. */
+static const char *buildFromRecords(const DJASTHeader *h,
+  const DJASTRecord *records, const int *nameNums, ASTree **root) {
+  /* stack of the cells still waiting for their nodes, next on top */
+  size_t stackSize = 64, top = 0;
+  ASTList **dest = malloc(sizeof(ASTList *) * stackSize);
+  if (dest == NULL) printError("malloc in loadASTFile()");
+  ASTList rootCell = { NULL, NULL };
+  dest[top++] = &rootCell;
+
+  const char *problem = NULL;
+  for (uint32_t i = 0; i < h->numRecords && problem == NULL; i++) {
+    const DJASTRecord *r = &records[i];
+    if (top == 0) {
+      problem = "records after the end of the tree";
+      break;
+    }
+    ASTList *into = dest[--top];
+    if (r->typ == DJAST_NO_NODE) {
+      if (r->numCells != 0) problem = "an empty cell with children";
+      continue;
+    }
+    if (r->typ > NAT_LITERAL_EXPR) problem = "unknown node type";
+    else if (r->idNum < -1 || r->idNum >= (int32_t)h->numNames)
+      problem = "name index out of range";
+    else if (r->numCells > h->numRecords - i - 1)
+      problem = "more children than records";
+    if (problem != NULL) break;
+
+    ASTree *n = arenaAlloc(&astArena, sizeof(ASTree));
+    n->typ = r->typ;
+    n->lineNumber = r->lineNumber;
+    n->natVal = r->natVal;
+    n->idNum = r->idNum < 0 ? -1 : nameNums[r->idNum];
+    n->idVal = r->idNum < 0 ? NULL : nameText(n->idNum);
+    n->staticClassNum = r->staticClassNum;
+    n->staticMemberNum = r->staticMemberNum;
+    n->staticType = r->staticType;
+    n->varKind = VAR_UNRESOLVED;
+    n->varOffset = 0;
+    n->children = n->childrenTail = NULL;
+    into->data = n;
+    uint32_t m = r->numCells;
+    if (m == 0) continue;
+
+    ASTList *cells = arenaAlloc(&astArena, sizeof(ASTList) * m);
+    n->children = cells;
+    n->childrenTail = &cells[m - 1];
+    if (top + m > stackSize) {
+      while (top + m > stackSize) stackSize *= 2;
+      dest = realloc(dest, sizeof(ASTList *) * stackSize);
+      if (dest == NULL) printError("realloc in loadASTFile()");
+    }
+    for (uint32_t c = 0; c < m; c++) {
+      cells[c].data = NULL;
+      cells[c].next = (c + 1 < m) ? &cells[c + 1] : NULL;
+      dest[top + m - 1 - c] = &cells[c];
+    }
+    top += m;
+  }
+  if (problem == NULL && top != 0) problem = "the tree ends early";
+  free(dest);
+  *root = rootCell.data;
+  return problem;
+}
+
+/* Load a tree from a .djast file */
+ASTree *loadASTFile(char *filename) {
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    if (fd >= 0) close(fd);
+    printf("ERROR: could not open file %s\n", filename);
+    compileFailed(-1);
+  }
+  size_t size = (size_t)st.st_size;
+  char *base = size > 0
+    ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED || size < sizeof(DJASTHeader)) {
+    if (base != MAP_FAILED) munmap(base, size);
+    printf("ERROR: %s is not a .djast file\n", filename);
+    compileFailed(-1);
+  }
+
+  const DJASTHeader *h = (const DJASTHeader *)base;
+  const char *problem = NULL;
+  size_t namesEnd = sizeof *h + ((size_t)h->nameBytes + 3) / 4 * 4;
+  if (h->magic != DJAST_MAGIC)
+    problem = "bad magic number (not a .djast file, or wrong byte order)";
+  else if (h->version != DJAST_VERSION)
+    problem = "unsupported format version";
+  else if (h->numNames > h->nameBytes)
+    problem = "name table overruns its length";
+  else if (namesEnd > size || (size - namesEnd) / sizeof(DJASTRecord) <
+           h->numRecords || h->numRecords == 0)
+    problem = "file is truncated";
+
+  /* intern the file's names, remembering their numbers here */
+  int *nameNums = NULL;
+  if (problem == NULL) {
+    nameNums = malloc(sizeof(int) * (h->numNames + 1));
+    if (nameNums == NULL) printError("malloc in loadASTFile()");
+    const char *text = base + sizeof *h;
+    const char *textEnd = text + h->nameBytes;
+    for (uint32_t i = 0; i < h->numNames && problem == NULL; i++) {
+      const char *nul = memchr(text, '\0', textEnd - text);
+      if (nul == NULL) problem = "name table overruns its length";
+      else {
+        nameNums[i] = internName(text, nul - text);
+        text = nul + 1;
+      }
+    }
+  }
+
+  ASTree *root = NULL;
+  if (problem == NULL)
+    problem = buildFromRecords(h, (const DJASTRecord *)(base + namesEnd),
+                               nameNums, &root);
+  free(nameNums);
+  munmap(base, size);
+  if (problem != NULL) {
+    printf("ERROR: bad .djast file %s: %s\n", filename, problem);
+    compileFailed(-1);
+  }
+  return root;
+}
+
+/* Does filename end in .djast? */
+int isASTFileName(char *filename) {
+  size_t len = strlen(filename);
+  return len >= 6 && strcmp(filename + len - 6, ".djast") == 0;
+}
+
+/* Free every AST node at once */
+void releaseAST() { arenaRelease(&astArena); }
@@ -1,165 +1,310 @@
-/* DJ PARSER */
-%code provides {
-  #include "lex.yy.c"
-  #include "ast.h"
-  #include "stdio.h"
-  #define YYSTYPE ASTree *
-
-
-  ASTree *pgmAST;
-
-  /* Function for printing generic syntax-error messages */
-  void yyerror(const char *str) {
-    printf("Syntax error on line %d at token %s\n", yylineno, yytext);
-    printf("(This version of the compiler exits after finding the first ");
-    printf("syntax error.)\n");
-    exit(-1);
-  }
-
-}
-
-%token FINAL CLASS ID EXTENDS MAIN NATTYPE 
-%token NATLITERAL PRINTNAT READNAT PLUS MINUS TIMES EQUALITY LESS
-%token ASSERT OR NOT IF ELSE WHILE
-%token ASSIGN NUL NEW THIS DOT 
-%token SEMICOLON LBRACE RBRACE LPAREN RPAREN
-%token ENDOFFILE
-
-%start pgm
-
-%right ASSERT
-%right ASSIGN
-%nonassoc LESS
-%nonassoc EQUALITY 
-%right NOT 
-%left OR
-%left PLUS MINUS
-%left TIMES
-%left DOT
-
-%%
-
-pgm:
-    class_declarations main_block ENDOFFILE
-    {$$ = newAST(PROGRAM, $1, 0, NULL, yylineno); appendToChildrenList($$, $2);}
-    {pgmAST =$1; return 0;}
-    ;
-
-class_declarations:
-    /* empty */ { $$ = newAST(CLASS_DECL_LIST, NULL, 0, NULL, yylineno); }
-    | class_declarations class_declaration
-      { $$ = newAST(CLASS_DECL_LIST, $1, 0, NULL, yylineno); appendToChildrenList($$, $2); }
-    ;
-
-class_declaration:
-    final_class_declaration
-    {$$ = newAST(FINAL_CLASS_DECL, $1, 0, NULL, yylineno);}
-    | nonfinal_class_declaration
-    {$$ = newAST(NONFINAL_CLASS_DECL, $1, 0, NULL, yylineno);}
-    ;
-
-final_class_declaration:
-    FINAL CLASS id EXTENDS id LBRACE var_declarations method_decl_check RBRACE
-    { $$ = newAST(FINAL_CLASS_DECL, $7, 0, $3, yylineno); appendToChildrenList($$, $8); }
-    ;
-
-nonfinal_class_declaration:
-    CLASS id EXTENDS id LBRACE var_declarations method_decl_check RBRACE
-    { $$ = newAST(NONFINAL_CLASS_DECL, $6, 0, $2, yylineno); appendToChildrenList($$, $7); }
-    ;
-
-var_declarations:
-    /* empty */ { $$ = newAST(VAR_DECL_LIST, NULL, 0, NULL, yylineno); }
-    | var_declarations var_declaration
-      { $$ = newAST(VAR_DECL_LIST, $1, 0, NULL, yylineno); appendToChildrenList($$, $2); }
-    ;
-
-var_declaration:
-    type id SEMICOLON
-    { $$ = newAST(VAR_DECL, NULL, 0, $2, yylineno); }
-    ;
-
-type:
-    NATTYPE { $$ = newAST(NAT_TYPE, NULL, atoi(yytext), NULL, yylineno); }
-    | id { $$ = newAST(AST_ID, NULL, 0, $1, yylineno); }
-    ;
-
-method_decl_list:
-    method_declaration 
-    | method_decl_list method_declaration
-      { $$ = newAST(METHOD_DECL_LIST, $1, 0, NULL, yylineno); appendToChildrenList($$, $2); }
-    ;
-
-method_decl_check:
-    /* empty */ { $$ = newAST(METHOD_DECL_LIST, NULL, 0, NULL, yylineno); }
-    | method_decl_list
-    ;
-
-method_declaration:
-    final_method_declaration
-    | nonfinal_method_declaration
-    ;
-
-final_method_declaration:
-    FINAL type id LPAREN type id RPAREN var_expr_block
-    { $$ = newAST(FINAL_METHOD_DECL, $8, 0, $3, yylineno); appendToChildrenList($$, $2); }
-    ;
-
-nonfinal_method_declaration:
-    type id LPAREN type id RPAREN var_expr_block
-    { $$ = newAST(NONFINAL_METHOD_DECL, $7, 0, $2, yylineno); appendToChildrenList($$, $1); }
-    ;
-
-var_expr_block:
-    LBRACE var_declarations expr_list RBRACE
-    { $$ = newAST(EXPR_LIST, $2, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    ;
-
-id:
-    ID
-    {$$ = newAST(AST_ID, NULL, 0 yytext, yylineno)}
-    ;
-
-main_block:
-    MAIN var_expr_block
-    {$$ = $2}
-    ;
-
-expr_list:
-    expr SEMICOLON { $$ = newAST(EXPR_LIST, $1, 0, NULL, yylineno); }
-    | expr_list expr SEMICOLON
-      { appendToChildrenList($1, $2); $$ = $1; }
-    ;
-
-expr:
-    expr PLUS expr { $$ = newAST(PLUS_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | expr MINUS expr { $$ = newAST(MINUS_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | expr TIMES expr { $$ = newAST(TIMES_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | expr EQUALITY expr { $$ = newAST(EQUALITY_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | expr LESS expr { $$ = newAST(LESS_THAN_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | ASSERT expr { $$ = newAST(ASSERT_EXPR, $2, 0, NULL, yylineno); }
-    | NOT expr { $$ = newAST(NOT_EXPR, $2, 0, NULL, yylineno); }
-    | expr OR expr { $$ = newAST(OR_EXPR, $1, 0, NULL, yylineno); appendToChildrenList($$, $3); }
-    | NATLITERAL { $$ = newAST(NAT_LITERAL_EXPR, NULL, atoi(yytext), NULL, yylineno); }
-    | NUL { $$ = newAST(NULL_EXPR, NULL, 0, NULL, yylineno); }
-    | IF LPAREN expr RPAREN LBRACE expr_list RBRACE ELSE LBRACE expr_list RBRACE
-      { $$ = newAST(IF_THEN_ELSE_EXPR, $3, 0, NULL, yylineno); appendToChildrenList($$, $6); appendToChildrenList($$, $10); }
-    | WHILE LPAREN expr RPAREN LBRACE expr_list RBRACE
-      { $$ = newAST(WHILE_EXPR, $3, 0, NULL, yylineno); appendToChildrenList($$, $6); }
-    ;
-
-%%
-
-int main(int argc, char **argv) {
-  if (argc != 2) {
-    printf("Usage: parsedj filename\n");
-    exit(-1);
-  }
-  yyin = fopen(argv[1], "r");
-  if (yyin == NULL) {
-    printf("ERROR: could not open file %s\n", argv[1]);
-    exit(-1);
-  }
-  /* parse the input program */
-  return yyparse();
-}
+/* DJ PARSER */
+%code requires {
+  /* before bison declares yylval, so that it gets this type too */
+  #include "ast.h"
+  #define YYSTYPE ASTree *
+}
+
+%code provides {
+  /* the scanner's entry point is scanToken(); yylex() (below) wraps it
+     for the pure parser, which passes yylval's address, not a global */
+  #define YY_DECL int scanToken(void)
+  /* lex errors end the compile the same way syntax errors do */
+  #include "recover.h"
+  #define LEX_FAIL(status) compileFailed(status)
+  /* -DHANDSCAN selects the hand-written scanner over the flex one */
+  #ifdef HANDSCAN
+  #include "djscan.c"
+  #else
+  #include "lex.yy.c"
+  #endif
+  #include "ast.h"
+  #include "arena.h"
+  #include "timing.h"
+  #include "stdio.h"
+
+
+  /* per thread, so several threads can parse at once (each scanner
+     keeps its state per thread too) */
+  _Thread_local ASTree *pgmAST;
+
+  /* see digestTokens() in ast.h */
+  static _Thread_local Sha256 *tokenDigest = NULL;
+
+  void digestTokens(Sha256 *digest) { tokenDigest = digest; }
+
+  /* id and NATLITERAL rules read yytext themselves, so no token carries
+     a semantic value */
+  int yylex(YYSTYPE *lvalp) {
+    *lvalp = NULL;
+    int t = scanToken();
+    if (tokenDigest != NULL) {
+      sha256Update(tokenDigest, &t, sizeof t);
+      if (t == ID || t == NATLITERAL) {
+        /* the NUL ends the text, so adjacent names can't run together */
+        sha256Update(tokenDigest, yytext, yyleng + 1);
+      }
+    }
+    return t;
+  }
+
+  /* Function for printing generic syntax-error messages */
+  void yyerror(const char *str) {
+    (void)str;
+    printf("Syntax error on line %d at token %s\n", yylineno, yytext);
+    printf("(This version of the compiler exits after finding the first ");
+    printf("syntax error.)\n");
+    compileFailed(-1);
+  }
+
+}
+
+%define api.pure full
+
+%token FINAL CLASS ID EXTENDS MAIN NATTYPE 
+%token NATLITERAL PRINTNAT READNAT PLUS MINUS TIMES EQUALITY LESS
+%token ASSERT OR NOT IF ELSE WHILE
+%token ASSIGN NUL NEW THIS DOT 
+%token SEMICOLON LBRACE RBRACE LPAREN RPAREN
+%token ENDOFFILE
+
+%code {
+  /* A list node with no children yet; countChildren() and the later
+     passes expect an empty list to have none, not one NULL child */
+  static ASTree *emptyList(ASTNodeType t) {
+    ASTree *list = newAST(t, NULL, 0, NULL, yylineno);
+    list->children = list->childrenTail = NULL;
+    return list;
+  }
+
+  /* Append item to list, which may be empty; returns the list */
+  static ASTree *addToList(ASTree *list, ASTree *item) {
+    if (list->children == NULL) return newAST(list->typ, item, 0, NULL, list->lineNumber);
+    appendToChildrenList(list, item);
+    return list;
+  }
+
+  /* A node of type t with children a, b and c (b and c may be NULL) */
+  static ASTree *node(ASTNodeType t, ASTree *a, ASTree *b, ASTree *c) {
+    ASTree *n = newAST(t, a, 0, NULL, yylineno);
+    if (b != NULL) appendToChildrenList(n, b);
+    if (c != NULL) appendToChildrenList(n, c);
+    return n;
+  }
+}
+
+%start pgm
+
+/* lowest precedence first */
+%right ASSERT
+%right ASSIGN
+%left OR
+%nonassoc EQUALITY
+%nonassoc LESS
+%left PLUS MINUS
+%left TIMES
+%right NOT
+%left DOT
+
+%%
+
+/* The tree shapes are the ones setupSymbolTables() reads (symtbl.h):
+   PROGRAM: CLASS_DECL_LIST, VAR_DECL_LIST (main's locals), EXPR_LIST
+   class: name, superclass, EXPR_LIST of (VAR_DECL_LIST, METHOD_DECL_LIST)
+   method: name, return type, VAR_DECL (parameter), VAR_DECL_LIST, EXPR_LIST
+   VAR_DECL: name, type */
+
+pgm:
+    class_declarations MAIN LBRACE var_declarations expr_list RBRACE ENDOFFILE
+    { pgmAST = node(PROGRAM, $1, $4, $5); YYACCEPT; }
+    ;
+
+class_declarations:
+    /* empty */ { $$ = emptyList(CLASS_DECL_LIST); }
+    | class_declarations class_declaration { $$ = addToList($1, $2); }
+    ;
+
+class_declaration:
+    CLASS id EXTENDS id class_body
+    { $$ = node(NONFINAL_CLASS_DECL, $2, $4, $5); }
+    | FINAL CLASS id EXTENDS id class_body
+    { $$ = node(FINAL_CLASS_DECL, $3, $5, $6); }
+    ;
+
+/* the method list is never empty here, so "type id" can be read before
+   deciding between a field and a method */
+class_body:
+    LBRACE var_declarations RBRACE
+    { $$ = node(EXPR_LIST, $2, emptyList(METHOD_DECL_LIST), NULL); }
+    | LBRACE var_declarations method_declarations RBRACE
+    { $$ = node(EXPR_LIST, $2, $3, NULL); }
+    ;
+
+var_declarations:
+    /* empty */ { $$ = emptyList(VAR_DECL_LIST); }
+    | var_declarations var_declaration { $$ = addToList($1, $2); }
+    ;
+
+var_declaration:
+    type id SEMICOLON { $$ = node(VAR_DECL, $2, $1, NULL); }
+    ;
+
+type:
+    NATTYPE { $$ = newAST(NAT_TYPE, NULL, 0, NULL, yylineno); }
+    | id
+    ;
+
+method_declarations:
+    method_declaration { $$ = newAST(METHOD_DECL_LIST, $1, 0, NULL, yylineno); }
+    | method_declarations method_declaration { $$ = addToList($1, $2); }
+    ;
+
+method_declaration:
+    type id LPAREN type id RPAREN LBRACE var_declarations expr_list RBRACE
+    { $$ = node(NONFINAL_METHOD_DECL, $2, $1, node(VAR_DECL, $5, $4, NULL));
+      appendToChildrenList($$, $8); appendToChildrenList($$, $9); }
+    | FINAL type id LPAREN type id RPAREN LBRACE var_declarations expr_list RBRACE
+    { $$ = node(FINAL_METHOD_DECL, $3, $2, node(VAR_DECL, $6, $5, NULL));
+      appendToChildrenList($$, $9); appendToChildrenList($$, $10); }
+    ;
+
+id:
+    ID { $$ = newAST(AST_ID, NULL, 0, yytext, yylineno); }
+    ;
+
+expr_list:
+    expr SEMICOLON { $$ = newAST(EXPR_LIST, $1, 0, NULL, yylineno); }
+    | expr_list expr SEMICOLON { $$ = addToList($1, $2); }
+    ;
+
+expr:
+    expr PLUS expr { $$ = node(PLUS_EXPR, $1, $3, NULL); }
+    | expr MINUS expr { $$ = node(MINUS_EXPR, $1, $3, NULL); }
+    | expr TIMES expr { $$ = node(TIMES_EXPR, $1, $3, NULL); }
+    | expr EQUALITY expr { $$ = node(EQUALITY_EXPR, $1, $3, NULL); }
+    | expr LESS expr { $$ = node(LESS_THAN_EXPR, $1, $3, NULL); }
+    | expr OR expr { $$ = node(OR_EXPR, $1, $3, NULL); }
+    | NOT expr { $$ = node(NOT_EXPR, $2, NULL, NULL); }
+    | ASSERT expr { $$ = node(ASSERT_EXPR, $2, NULL, NULL); }
+    | NATLITERAL { $$ = newAST(NAT_LITERAL_EXPR, NULL, strtoul(yytext, NULL, 10), NULL, yylineno); }
+    | NUL { $$ = newAST(NULL_EXPR, NULL, 0, NULL, yylineno); }
+    | THIS { $$ = newAST(THIS_EXPR, NULL, 0, NULL, yylineno); }
+    | READNAT LPAREN RPAREN { $$ = newAST(READ_EXPR, NULL, 0, NULL, yylineno); }
+    | PRINTNAT LPAREN expr RPAREN { $$ = node(PRINT_EXPR, $3, NULL, NULL); }
+    | NEW id LPAREN RPAREN { $$ = node(NEW_EXPR, $2, NULL, NULL); }
+    | id { $$ = node(ID_EXPR, $1, NULL, NULL); }
+    | id ASSIGN expr { $$ = node(ASSIGN_EXPR, $1, $3, NULL); }
+    | id LPAREN expr RPAREN { $$ = node(METHOD_CALL_EXPR, $1, $3, NULL); }
+    | expr DOT id { $$ = node(DOT_ID_EXPR, $1, $3, NULL); }
+    | expr DOT id ASSIGN expr { $$ = node(DOT_ASSIGN_EXPR, $1, $3, $5); }
+    | expr DOT id LPAREN expr RPAREN { $$ = node(DOT_METHOD_CALL_EXPR, $1, $3, $5); }
+    | IF LPAREN expr RPAREN LBRACE expr_list RBRACE ELSE LBRACE expr_list RBRACE
+      { $$ = node(IF_THEN_ELSE_EXPR, $3, $6, $10); }
+    | WHILE LPAREN expr RPAREN LBRACE expr_list RBRACE
+      { $$ = node(WHILE_EXPR, $3, $6, NULL); }
+    | LPAREN expr RPAREN { $$ = $2; }
+    ;
+
+%%
+
+/* Point the scanner at the DJ program in filename */
+static void openSource(char *filename, int useMmap) {
+  if (useMmap) {
+    if (!mapSourceFile(filename)) {
+      printf("ERROR: could not open file %s\n", filename);
+      compileFailed(-1);
+    }
+  } else {
+    yyin = fopen(filename, "r");
+    if (yyin == NULL) {
+      printf("ERROR: could not open file %s\n", filename);
+      compileFailed(-1);
+    }
+  }
+}
+
+/* Lex the DJ program in filename without parsing it (see ast.h) */
+int lexFile(char *filename, int useMmap) {
+  openSource(filename, useMmap);
+  int numTokens = 0;
+  while (scanToken() != ENDOFFILE) numTokens++;
+  finishSource();
+  return numTokens;
+}
+
+/* Parse the DJ program in filename (see ast.h) */
+ASTree *parseFile(char *filename, int useMmap, int lexThreads) {
+  openSource(filename, useMmap);
+  #ifdef HANDSCAN
+  if (lexThreads > 0) lexInParallel(lexThreads);
+  #else
+  if (lexThreads > 0) printf("(-lexthreads needs the hand-written scanner; lexing serially)\n");
+  #endif
+  pgmAST = NULL;
+  beginPhase("yyparse");
+  yyparse();
+  endPhase();
+  finishSource();
+  /* lay the finished tree out contiguously for the later passes */
+  beginPhase("compactAST");
+  ASTree *compacted = compactAST(pgmAST);
+  endPhase();
+  return compacted;
+}
+
+/* -DNO_PARSEDJ_MAIN leaves parsedj's main() out, for programs that
+   link the scanner and parser into a bigger one */
+#ifndef NO_PARSEDJ_MAIN
+/* Print the tokens of the DJ program in filename, one per line as
+   "LINE TOKEN TEXT", for comparing the two scanners' token streams */
+static void printTokens(char *filename, int useMmap) {
+  openSource(filename, useMmap);
+  int t;
+  while ((t = scanToken()) != ENDOFFILE) printf("%d %d %s\n", yylineno, t, yytext);
+  printf("%d %d\n", yylineno, t);
+  finishSource();
+}
+
+int main(int argc, char **argv) {
+  /* Options:
+     -mmap           scan a memory mapping of the whole file, not yyin
+     -lexthreads N   (hand-written scanner only) lex the whole file on
+                     N threads before parsing starts
+     -memstats       report allocation counts and peak RSS after parsing
+     -writeast FILE  save the AST to the .djast file FILE (see ast.h)
+     -tokens         print the token stream instead of parsing
+     A filename ending in .djast is loaded instead of parsed. */
+  int useMmap = 0;
+  int memStats = 0;
+  char *astOut = NULL;
+  int lexThreads = 0;
+  int tokens = 0;
+  int arg = 1;
+  while (arg < argc - 1 && argv[arg][0] == '-') {
+    if (strcmp(argv[arg], "-mmap") == 0) useMmap = 1;
+    else if (strcmp(argv[arg], "-memstats") == 0) memStats = 1;
+    else if (strcmp(argv[arg], "-tokens") == 0) tokens = 1;
+    else if (strcmp(argv[arg], "-lexthreads") == 0 && arg + 1 < argc - 1)
+      lexThreads = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-writeast") == 0 && arg + 1 < argc - 1)
+      astOut = argv[++arg];
+    else break;
+    arg++;
+  }
+  if (arg != argc - 1) {
+    printf("Usage: parsedj [-mmap] [-lexthreads N] [-memstats] ");
+    printf("[-writeast FILE] [-tokens] filename\n");
+    exit(-1);
+  }
+  if (tokens) {
+    printTokens(argv[arg], useMmap);
+    return 0;
+  }
+  /* parse (or load) the input program */
+  if (isASTFileName(argv[arg])) pgmAST = loadASTFile(argv[arg]);
+  else pgmAST = parseFile(argv[arg], useMmap, lexThreads);
+  if (memStats) printMemoryStats(stdout);
+  if (astOut != NULL && writeASTFile(pgmAST, astOut) != 0) return -1;
+  return 0;
+}
+#endif
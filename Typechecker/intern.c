@@ -0,0 +1,133 @@
+/* File intern.c
+   Implementation of the DJ identifier interning table
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "intern.h"
+
+#define POOL_CHUNK_SIZE 65536
+
+/* The table is per thread, like the rest of the compiler's state */
+
+/* name number -> text */
+static _Thread_local char **names = NULL;
+static _Thread_local int namesCount = 0;
+static _Thread_local int namesCapacity = 0;
+
+/* open-addressing hash table of name numbers; -1 marks an empty slot */
+static _Thread_local int *buckets = NULL;
+static _Thread_local unsigned int numBuckets = 0;
+
+/* name text lives in large chunks that never move; each chunk starts
+   with a pointer to the previous one so they can all be freed */
+static _Thread_local char *pool = NULL;
+static _Thread_local size_t poolLeft = 0;
+static _Thread_local char *lastChunk = NULL;
+
+static void internError(char *reason) {
+  printf("Intern Error: %s\n", reason);
+  exit(-1);
+}
+
+static unsigned int hashName(const char *name, int len) {
+  unsigned int h = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char)name[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static char *copyToPool(const char *name, int len) {
+  if (poolLeft < (size_t)len + 1) {
+    size_t size = (size_t)len + 1 > POOL_CHUNK_SIZE ? (size_t)len + 1 : POOL_CHUNK_SIZE;
+    char *chunk = malloc(sizeof(char *) + size);
+    if (chunk == NULL) internError("malloc in copyToPool()");
+    memcpy(chunk, &lastChunk, sizeof(char *));
+    lastChunk = chunk;
+    pool = chunk + sizeof(char *);
+    poolLeft = size;
+  }
+  char *copy = pool;
+  memcpy(copy, name, len);
+  copy[len] = '\0';
+  pool += len + 1;
+  poolLeft -= len + 1;
+  return copy;
+}
+
+/* Double the hash table and reinsert every name */
+static void growBuckets(void) {
+  unsigned int newSize = numBuckets ? numBuckets * 2 : 1024;
+  int *newBuckets = malloc(sizeof(int) * newSize);
+  if (newBuckets == NULL) internError("malloc in growBuckets()");
+  memset(newBuckets, -1, sizeof(int) * newSize);
+  for (int i = 0; i < namesCount; i++) {
+    unsigned int b = hashName(names[i], strlen(names[i])) & (newSize - 1);
+    while (newBuckets[b] >= 0) b = (b + 1) & (newSize - 1);
+    newBuckets[b] = i;
+  }
+  free(buckets);
+  buckets = newBuckets;
+  numBuckets = newSize;
+}
+
+/* Returns the bucket holding the name, or the empty bucket where it belongs */
+static unsigned int findBucket(const char *name, int len) {
+  unsigned int b = hashName(name, len) & (numBuckets - 1);
+  while (buckets[b] >= 0) {
+    char *text = names[buckets[b]];
+    if (strncmp(text, name, len) == 0 && text[len] == '\0') return b;
+    b = (b + 1) & (numBuckets - 1);
+  }
+  return b;
+}
+
+int internName(const char *name, int len) {
+  if (name == NULL || len < 0) internError("bad name in internName()");
+  /* keep the table at most half full */
+  if ((unsigned int)(namesCount + 1) * 2 > numBuckets) growBuckets();
+  unsigned int b = findBucket(name, len);
+  if (buckets[b] >= 0) return buckets[b];
+
+  if (namesCount == namesCapacity) {
+    namesCapacity = namesCapacity ? namesCapacity * 2 : 1024;
+    names = realloc(names, sizeof(char *) * namesCapacity);
+    if (names == NULL) internError("realloc in internName()");
+  }
+  names[namesCount] = copyToPool(name, len);
+  buckets[b] = namesCount;
+  return namesCount++;
+}
+
+int findName(const char *name) {
+  if (name == NULL || numBuckets == 0) return -1;
+  unsigned int b = findBucket(name, strlen(name));
+  return buckets[b];
+}
+
+char *nameText(int nameNum) {
+  if (nameNum < 0 || nameNum >= namesCount) return NULL;
+  return names[nameNum];
+}
+
+int numNames(void) { return namesCount; }
+
+void releaseNames(void) {
+  while (lastChunk != NULL) {
+    char *previous;
+    memcpy(&previous, lastChunk, sizeof(char *));
+    free(lastChunk);
+    lastChunk = previous;
+  }
+  free(names);
+  free(buckets);
+  names = NULL;
+  namesCount = namesCapacity = 0;
+  buckets = NULL;
+  numBuckets = 0;
+  pool = NULL;
+  poolLeft = 0;
+}
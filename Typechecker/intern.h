@@ -0,0 +1,31 @@
+/* File intern.h: Identifier interning table for DJ */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+/* Every distinct identifier in the program is stored exactly once and
+   given a dense number: 0 for the first name interned, 1 for the next,
+   and so on.  Two identifiers are the same name iff their numbers are
+   equal, so later stages compare names with == instead of strcmp.
+   Each thread has its own table. */
+
+/* Returns the number for the len-character name starting at name,
+   adding the name to the table if it has not been seen before.
+   The name does not need to be NUL-terminated. */
+int internName(const char *name, int len);
+
+/* Returns the number of a NUL-terminated name, or -1 if the name
+   has never been interned. */
+int findName(const char *name);
+
+/* Returns the (NUL-terminated) text of the name with number nameNum */
+char *nameText(int nameNum);
+
+/* Returns how many distinct names have been interned so far */
+int numNames(void);
+
+/* Forget every name, freeing the table.  All name numbers and texts
+   handed out so far become invalid. */
+void releaseNames(void);
+
+#endif
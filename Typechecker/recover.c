@@ -0,0 +1,28 @@
+/* File recover.c
+   Implementation of error recovery for the DJ compiler
+*/
+
+#include <stdlib.h>
+#include <setjmp.h>
+#include "recover.h"
+
+/* where compileFailed() should unwind to, or NULL to just exit */
+static _Thread_local jmp_buf *recoveryPoint = NULL;
+
+_Noreturn void compileFailed(int status) {
+  if (recoveryPoint == NULL) exit(status);
+  longjmp(*recoveryPoint, 1);
+}
+
+int tryCompile(void (*phase)(void *arg), void *arg) {
+  jmp_buf here;
+  jmp_buf *outer = recoveryPoint;
+  if (setjmp(here) != 0) {
+    recoveryPoint = outer;
+    return 1;
+  }
+  recoveryPoint = &here;
+  phase(arg);
+  recoveryPoint = outer;
+  return 0;
+}
@@ -0,0 +1,28 @@
+/* File sha256.h: SHA-256 message digests for DJ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_BYTES 32
+
+/* Digest of a message fed in piece by piece */
+typedef struct {
+  uint32_t state[8];
+  uint64_t length;        /* bytes fed in so far */
+  unsigned char block[64];
+  size_t blockUsed;       /* bytes of block waiting to be compressed */
+} Sha256;
+
+/* Start a new digest */
+void sha256Init(Sha256 *d);
+
+/* Feed len more bytes of the message into d */
+void sha256Update(Sha256 *d, const void *data, size_t len);
+
+/* Finish d, storing its SHA256_BYTES-byte digest in out */
+void sha256Final(Sha256 *d, unsigned char out[SHA256_BYTES]);
+
+#endif
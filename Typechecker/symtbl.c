@@ -1,206 +1,496 @@
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-#include "symtbl.h"
-
-ASTree *wholeProgram = NULL;
-ASTree *mainExprs = NULL;
-int numMainBlockLocals = 0;
-VarDecl *mainBlockST = NULL;
-int numClasses = 0;
-ClassDecl *classesST = NULL;
-
-/* Function to return the number of children for a given AST node */
-int countChildren(ASTree *tree) {
-    if (!tree || !tree->children) return 0;
-
-    int count = 0;
-    ASTList *curr = tree->children;
-    while (curr) {
-        count++;
-        curr = curr->next;
-        //printf("count: %d\n", count);
-    }
-    return count;
-}
-
-int classNameToNumber(char *className) {
-    if (!className) return -3;
-
-    if (strcmp(className, "Object") == 0) return 0;
-
-    for (int i = 1; i < numClasses; i++) {
-        if (strcmp(classesST[i].className, className) == 0) {
-            return i;
-        }
-    }
-
-    return -3;
-}
-
-void setupSymbolTables(ASTree *fullProgramAST) {
-    //printf("Setting up symbol tables... ");
-    if (!fullProgramAST || countChildren(fullProgramAST) < 3) {
-        fprintf(stderr, "Malformed AST: not enough children.\n");
-        exit(1);
-    }
-    //printf(" in the code\n");
-    
-    wholeProgram = fullProgramAST;
-    ASTree *classList = fullProgramAST->children->data; // First child
-    ASTree *mainVarDecls = fullProgramAST->children->next->data; // Second child
-    mainExprs = fullProgramAST->children->next->next->data; // Third child
-    
-
-    // Set up main block locals
-    numMainBlockLocals = countChildren(mainVarDecls);
-    mainBlockST = malloc(sizeof(VarDecl) * numMainBlockLocals);
-    if (!mainBlockST) {
-        fprintf(stderr, "Memory allocation failed for mainBlockST.\n");
-        exit(1);
-    }
-    memset(mainBlockST, 0, sizeof(VarDecl) * numMainBlockLocals);
-
-    for (int i = 0; i < numMainBlockLocals; i++) {
-        ASTree *vdecl = mainVarDecls->children->data; // First child of the mainVarDecls
-        if (!vdecl || countChildren(vdecl) < 2) continue;
-
-        ASTree *idNode = vdecl->children->data;
-        ASTree *typeNode = vdecl->children->next->data;
-
-        mainBlockST[i].varName = idNode ? idNode->idVal : NULL;
-        mainBlockST[i].varNameLineNumber = idNode ? idNode->lineNumber : -1;
-        mainBlockST[i].type = typeNode && typeNode->idVal ? classNameToNumber(typeNode->idVal) : -3;
-        mainBlockST[i].typeLineNumber = typeNode ? typeNode->lineNumber : -1;
-    }
-
-    // Safely determine number of classes
-    int userClassCount = classList ? countChildren(classList) : 0;
-    numClasses = userClassCount;
-    classesST = malloc(sizeof(ClassDecl) * (numClasses +1));
-    if (!classesST) {
-        fprintf(stderr, "Memory allocation failed for classesST.\n");
-        exit(1);
-    }
-    memset(classesST, 0, sizeof(ClassDecl) * numClasses);
-
-    // Add Object class
-    classesST[0].className = "Object";
-    classesST[0].classNameLineNumber = 0;
-    classesST[0].superclass = -3;
-    classesST[0].superclassLineNumber = 0;
-    classesST[0].isFinal = 0;
-    classesST[0].numVars = 0;
-    classesST[0].varList = NULL;
-    classesST[0].numMethods = 0;
-    classesST[0].methodList = NULL;
-
-    // Add user-defined classes if any
-    if (userClassCount > 0 && classList && classList->children->data) {
-        for (int i = 0; i < userClassCount; i++) {
-            
-            ASTree *classAST = classList->children->data;
-            ClassDecl *classDecl = &classesST[i + 1];
-            
-            ASTree *idNode = classAST->children->data;
-            
-            ASTree *superclassNode = classAST->children->next->data;
-            
-            ASTree *fieldList = classAST->children->next->next->data;
-            
-
-            classDecl->className = idNode ? idNode->idVal : NULL;
-            classDecl->classNameLineNumber = idNode ? idNode->lineNumber : -1;
-            classDecl->superclass = (superclassNode && superclassNode->idVal) ? classNameToNumber(superclassNode->idVal) : -3;
-            classDecl->superclassLineNumber = superclassNode ? superclassNode->lineNumber : -1;
-            classDecl->isFinal = (classAST->typ == FINAL_CLASS_DECL);
-
-            // Variable fields
-            ASTree *varsNode = fieldList->children->data;
-            classDecl->numVars = varsNode ? countChildren(varsNode) : 0;
-            classDecl->varList = malloc(sizeof(VarDecl) * classDecl->numVars);
-            if (!classDecl->varList && classDecl->numVars > 0) {
-                fprintf(stderr, "Memory allocation failed for varList of class %s.\n", classDecl->className);
-                exit(1);
-            }
-            memset(classDecl->varList, 0, sizeof(VarDecl) * classDecl->numVars);
-
-            for (int j = 0; j < classDecl->numVars; j++) {
-                ASTree *vdecl = varsNode->children->data;
-                ASTree *idNode = vdecl->children->data;
-                ASTree *typeNode = vdecl->children->next->data;
-
-                classDecl->varList[j].varName = idNode ? idNode->idVal : NULL;
-                classDecl->varList[j].varNameLineNumber = idNode ? idNode->lineNumber : -1;
-                classDecl->varList[j].type = typeNode && typeNode->idVal ? classNameToNumber(typeNode->idVal) : -3;
-                classDecl->varList[j].typeLineNumber = typeNode ? typeNode->lineNumber : -1;
-            }
-
-            // Methods
-            //printf("methods started\n");
-            ASTList *methodListNode = fieldList->children ? fieldList->children->next : NULL;
-            ASTree *methodsNode = methodListNode ? methodListNode->data : NULL;
-
-            classDecl->numMethods = methodsNode ? countChildren(methodsNode) : 0;
-            classDecl->methodList = malloc(sizeof(MethodDecl) * classDecl->numMethods);
-            
-            if (classDecl->numMethods > 0) {
-                if (!classDecl->methodList) {
-                    fprintf(stderr, "Memory allocation failed for methodList of class %s.\n", classDecl->className);
-                    exit(1);
-                }
-                memset(classDecl->methodList, 0, sizeof(MethodDecl) * classDecl->numMethods);
-
-                for (int j = 0; j < classDecl->numMethods; j++) {
-                    ASTree *methodDeclNode = methodsNode->children->data;
-                    MethodDecl *method = &classDecl->methodList[j];
-
-                    method->methodName = methodDeclNode && methodDeclNode->children ? methodDeclNode->children->data->idVal : NULL;
-                    method->methodNameLineNumber = methodDeclNode && methodDeclNode->children ? methodDeclNode->children->data->lineNumber : -1;
-
-                    ASTree *retTypeNode = methodDeclNode && methodDeclNode->children->next ? methodDeclNode->children->next->data : NULL;
-                    method->returnType = retTypeNode && retTypeNode->idVal ? classNameToNumber(retTypeNode->idVal) : -3;
-                    method->returnTypeLineNumber = retTypeNode ? retTypeNode->lineNumber : -1;
-
-                    ASTree *paramDeclNode = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
-                                            methodDeclNode->children->next->next->data : NULL;
-                    ASTree *paramIdNode = paramDeclNode && paramDeclNode->children ? paramDeclNode->children->data : NULL;
-                    ASTree *paramTypeNode = paramDeclNode && paramDeclNode->children && paramDeclNode->children->next ?
-                                            paramDeclNode->children->next->data : NULL;
-
-                    method->paramName = paramIdNode ? paramIdNode->idVal : NULL;
-                    method->paramNameLineNumber = paramIdNode ? paramIdNode->lineNumber : -1;
-                    method->paramType = paramTypeNode && paramTypeNode->idVal ? classNameToNumber(paramTypeNode->idVal) : -3;
-                    method->paramTypeLineNumber = paramTypeNode ? paramTypeNode->lineNumber : -1;
-                    method->isFinal = (methodDeclNode->typ == FINAL_METHOD_DECL);
-
-                    ASTree *localsNode = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
-                                         methodDeclNode->children->next->next->next->data : NULL;
-                    method->numLocals = localsNode ? countChildren(localsNode) : 0;
-                    method->localST = malloc(sizeof(VarDecl) * method->numLocals);
-                    if (method->numLocals > 0 && !method->localST) {
-                        fprintf(stderr, "Memory allocation failed for locals in method %s of class %s.\n", method->methodName, classDecl->className);
-                        exit(1);
-                    }
-                    memset(method->localST, 0, sizeof(VarDecl) * method->numLocals);
-
-                    for (int k = 0; k < method->numLocals; k++) {
-                        ASTree *vdecl = localsNode && localsNode->children ? localsNode->children->data : NULL;
-                        ASTree *idNode = vdecl && vdecl->children ? vdecl->children->data : NULL;
-                        ASTree *typeNode = vdecl && vdecl->children && vdecl->children->next ? vdecl->children->next->data : NULL;
-
-                        method->localST[k].varName = idNode ? idNode->idVal : NULL;
-                        method->localST[k].varNameLineNumber = idNode ? idNode->lineNumber : -1;
-                        method->localST[k].type = typeNode && typeNode->idVal ? classNameToNumber(typeNode->idVal) : -3;
-                        method->localST[k].typeLineNumber = typeNode ? typeNode->lineNumber : -1;
-                    }
-
-                    method->bodyExprs = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
-                                        methodDeclNode->children->next->next->next->data : NULL;
-                }
-            }
-        }
-    }
-
-   // printf("Finished setting up symbol tables.\n");
-}
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "symtbl.h"
+#include "intern.h"
+#include "arena.h"
+#include "recover.h"
+
+_Thread_local ASTree *wholeProgram = NULL;
+_Thread_local ASTree *mainExprs = NULL;
+_Thread_local int numMainBlockLocals = 0;
+_Thread_local VarDecl *mainBlockST = NULL;
+_Thread_local NameIndex mainBlockIndex = { 0, NULL };
+_Thread_local int numClasses = 0;
+_Thread_local ClassDecl *classesST = NULL;
+
+// interned number of the name "Object", set in setupSymbolTables
+static _Thread_local int objectNameNum = -1;
+// index of classesST by class name
+static _Thread_local NameIndex classIndex = { 0, NULL };
+// size of every class's ancestors array
+static _Thread_local int ancestorLevels = 0;
+
+/* Function to return the number of children for a given AST node */
+int countChildren(ASTree *tree) {
+    if (!tree || !tree->children) return 0;
+
+    int count = 0;
+    ASTList *curr = tree->children;
+    while (curr) {
+        count++;
+        curr = curr->next;
+    }
+    return count;
+}
+
+/* Start an empty index with room for count names */
+static void indexInit(NameIndex *index, int count) {
+    unsigned int size = 4;
+    while (size < 2u * (unsigned int)count) size *= 2;
+    index->mask = size - 1;
+    index->slots = arenaAlloc(&symtblArena, sizeof(int) * 2 * size);
+    for (unsigned int i = 0; i < size; i++) index->slots[2 * i] = -1;
+}
+
+/* Record that name nameNum is at position pos, unless it already has a
+   position (so duplicates keep their first one) */
+static void indexAdd(NameIndex *index, int nameNum, int pos) {
+    if (nameNum < 0) return;
+    unsigned int i = ((unsigned int)nameNum * 2654435761u) & index->mask;
+    while (index->slots[2 * i] != -1) {
+        if (index->slots[2 * i] == nameNum) return;
+        i = (i + 1) & index->mask;
+    }
+    index->slots[2 * i] = nameNum;
+    index->slots[2 * i + 1] = pos;
+}
+
+int indexLookup(const NameIndex *index, int nameNum) {
+    if (index->slots == NULL || nameNum < 0) return -1;
+    unsigned int i = ((unsigned int)nameNum * 2654435761u) & index->mask;
+    while (index->slots[2 * i] != -1) {
+        if (index->slots[2 * i] == nameNum) return index->slots[2 * i + 1];
+        i = (i + 1) & index->mask;
+    }
+    return -1;
+}
+
+/* Build the index of an array of count variable declarations */
+static void indexVars(NameIndex *index, VarDecl *vars, int count) {
+    indexInit(index, count);
+    for (int i = 0; i < count; i++) indexAdd(index, vars[i].varNameNum, i);
+}
+
+int classNameToNumber(char *className) {
+    if (!className) return -3;
+    if (strcmp(className, "Object") == 0) return 0;
+    return classNumberOf(findName(className));
+}
+
+int classNumberOf(int nameNum) {
+    if (nameNum < 0) return -3;
+
+    if (nameNum == objectNameNum) return 0;
+
+    int i = indexLookup(&classIndex, nameNum);
+    return i > 0 ? i : -3;
+}
+
+/* (These searches give up after numClasses steps, in case the
+   superclasses form a cycle, which the typechecker reports.) */
+VarDecl *findField(int cls, int nameNum, int *declaringClass) {
+    for (int steps = 0; cls >= 0 && steps < numClasses; steps++) {
+        int i = indexLookup(&classesST[cls].varIndex, nameNum);
+        if (i >= 0) {
+            if (declaringClass) *declaringClass = cls;
+            return &classesST[cls].varList[i];
+        }
+        cls = classesST[cls].superclass;
+    }
+    return NULL;
+}
+
+MethodDecl *findMethod(int cls, int nameNum, int *declaringClass) {
+    for (int steps = 0; cls >= 0 && steps < numClasses; steps++) {
+        int i = indexLookup(&classesST[cls].methodIndex, nameNum);
+        if (i >= 0) {
+            if (declaringClass) *declaringClass = cls;
+            return &classesST[cls].methodList[i];
+        }
+        cls = classesST[cls].superclass;
+    }
+    return NULL;
+}
+
+/* Build the object layout and method slots (see symtbl.h) of class c,
+   whose superclass super (or 0, for none) has been laid out already */
+static void layoutClass(int c, int super) {
+    ClassDecl *cls = &classesST[c];
+    ClassDecl *superDecl = &classesST[super];
+
+    cls->fieldOffsets = arenaAlloc(&symtblArena, sizeof(int) * cls->numVars);
+    for (int j = 0; j < cls->numVars; j++) cls->fieldOffsets[j] = superDecl->objectSize + j;
+    cls->objectSize = superDecl->objectSize + cls->numVars;
+
+    cls->slots = arenaAlloc(&symtblArena, sizeof(MethodSlot) * (superDecl->numSlots + cls->numMethods));
+    if (superDecl->numSlots > 0)
+        memcpy(cls->slots, superDecl->slots, sizeof(MethodSlot) * superDecl->numSlots);
+    cls->numSlots = superDecl->numSlots;
+    for (int j = 0; j < cls->numMethods; j++) {
+        MethodDecl *method = &cls->methodList[j];
+        MethodDecl *overridden = super > 0 ? findMethod(super, method->methodNameNum, NULL) : NULL;
+        // (the bound only matters when the superclasses form a cycle)
+        if (overridden && overridden->slot < superDecl->numSlots) method->slot = overridden->slot;
+        else method->slot = cls->numSlots++;
+        cls->slots[method->slot].classNum = c;
+        cls->slots[method->slot].methodNum = j;
+        cls->slots[method->slot].overridden = 0;
+    }
+}
+
+/* Lay out every class, each after its superclass.
+   A superclass may be declared after its subclasses, so each class
+   walks up to the nearest ancestor already laid out and then lays out
+   the classes below it.  (An inheritance cycle, reported later by the
+   typechecker, is just treated as reaching Object.) */
+static void layoutClasses(void) {
+    int *chain = arenaAlloc(&symtblArena, sizeof(int) * numClasses);
+    classesST[0].objectSize = OBJECT_HEADER + 1;
+    classesST[0].numSlots = 0;
+    classesST[0].slots = NULL;
+    for (int i = 1; i < numClasses; i++) {
+        int chainLength = 0;
+        int c = i;
+        while (c > 0 && classesST[c].objectSize == 0) {
+            classesST[c].objectSize = -1; // being laid out
+            chain[chainLength++] = c;
+            c = classesST[c].superclass;
+        }
+        int super = c > 0 && classesST[c].objectSize > 0 ? c : 0;
+        while (chainLength > 0) {
+            c = chain[--chainLength];
+            layoutClass(c, super);
+            super = c;
+        }
+    }
+}
+
+/* Number every class's place in the inheritance trees (see symtbl.h).
+   Each class whose superclass is not a class is a root; the classes
+   that no root reaches are on or below a cycle. */
+static void numberHierarchy(void) {
+    int *firstChild = arenaAlloc(&symtblArena, sizeof(int) * numClasses);
+    int *nextSibling = arenaAlloc(&symtblArena, sizeof(int) * numClasses);
+    int *stack = arenaAlloc(&symtblArena, sizeof(int) * numClasses);
+    for (int i = 0; i < numClasses; i++) firstChild[i] = -1;
+    // link the children in reverse, so the walk visits them in order
+    for (int i = numClasses - 1; i >= 0; i--) {
+        int super = classesST[i].superclass;
+        if (super >= 0 && super < numClasses) {
+            nextSibling[i] = firstChild[super];
+            firstChild[super] = i;
+        }
+        classesST[i].preorder = classesST[i].lastDescendant = classesST[i].depth = -1;
+    }
+
+    // preorder walk of each tree; firstChild[c] advances to the next
+    // child to visit, and c is popped once it has none left
+    int next = 0, maxDepth = 0;
+    for (int root = 0; root < numClasses; root++) {
+        int super = classesST[root].superclass;
+        if (super >= 0 && super < numClasses) continue;
+        int height = 0;
+        stack[height++] = root;
+        classesST[root].preorder = next++;
+        classesST[root].depth = 0;
+        while (height > 0) {
+            int c = stack[height - 1];
+            int child = firstChild[c];
+            if (child < 0) {
+                classesST[c].lastDescendant = next - 1;
+                height--;
+                continue;
+            }
+            firstChild[c] = nextSibling[child];
+            classesST[child].preorder = next++;
+            classesST[child].depth = classesST[c].depth + 1;
+            if (classesST[child].depth > maxDepth) maxDepth = classesST[child].depth;
+            stack[height++] = child;
+        }
+    }
+
+    // binary lifting tables, parents first (i.e., in preorder)
+    ancestorLevels = 1;
+    while ((1 << ancestorLevels) <= maxDepth) ancestorLevels++;
+    int *byPreorder = stack;
+    for (int i = 0; i < numClasses; i++) {
+        classesST[i].ancestors = arenaAlloc(&symtblArena, sizeof(int) * ancestorLevels);
+        if (classesST[i].preorder >= 0) byPreorder[classesST[i].preorder] = i;
+    }
+    for (int p = 0; p < next; p++) {
+        ClassDecl *cls = &classesST[byPreorder[p]];
+        cls->ancestors[0] = cls->depth > 0 ? cls->superclass : byPreorder[p];
+        for (int k = 1; k < ancestorLevels; k++)
+            cls->ancestors[k] = classesST[cls->ancestors[k - 1]].ancestors[k - 1];
+    }
+
+    // mark the overridden slots, subclasses first (i.e., in reverse preorder)
+    for (int p = next - 1; p >= 0; p--) {
+        ClassDecl *cls = &classesST[byPreorder[p]];
+        if (cls->depth <= 0) continue;
+        ClassDecl *superDecl = &classesST[cls->superclass];
+        for (int s = 0; s < superDecl->numSlots; s++) {
+            MethodSlot *mine = &cls->slots[s];
+            if (mine->overridden || mine->classNum != superDecl->slots[s].classNum
+                || mine->methodNum != superDecl->slots[s].methodNum)
+                superDecl->slots[s].overridden = 1;
+        }
+    }
+}
+
+int isSubclass(int sub, int super) {
+    return classesST[sub].preorder >= 0
+        && classesST[super].preorder <= classesST[sub].preorder
+        && classesST[sub].preorder <= classesST[super].lastDescendant;
+}
+
+int commonSuperclass(int c1, int c2) {
+    if (classesST[c1].depth < 0 || classesST[c2].depth < 0) return -3;
+    if (classesST[c1].depth < classesST[c2].depth) { int t = c1; c1 = c2; c2 = t; }
+    // lift c1 to c2's depth, then both to just below their meeting point
+    for (int k = ancestorLevels - 1; k >= 0; k--)
+        if (classesST[c1].depth - (1 << k) >= classesST[c2].depth) c1 = classesST[c1].ancestors[k];
+    if (c1 == c2) return c1;
+    for (int k = ancestorLevels - 1; k >= 0; k--)
+        if (classesST[c1].ancestors[k] != classesST[c2].ancestors[k]) {
+            c1 = classesST[c1].ancestors[k];
+            c2 = classesST[c2].ancestors[k];
+        }
+    // two roots here means two different trees
+    return classesST[c1].depth > 0 ? classesST[c1].ancestors[0] : -3;
+}
+
+/* Set the resolution attributes (see ast.h) of node t */
+static void recordVar(ASTree *t, VarKind kind, int offset, int classNum, int memberNum) {
+    t->varKind = kind;
+    t->varOffset = offset;
+    t->staticClassNum = classNum;
+    t->staticMemberNum = memberNum;
+}
+
+/* Resolve the variable named by idNode, used in method method of class
+   cls (or the main block, if cls < 0), and record it on t and idNode */
+static void resolveVar(ASTree *t, ASTree *idNode, int cls, int method) {
+    VarKind kind = VAR_UNRESOLVED;
+    int classNum = 0, memberNum = 0, offset = 0;
+    if (cls < 0) {
+        int i = indexLookup(&mainBlockIndex, idNode->idNum);
+        if (i >= 0) { kind = VAR_LOCAL; memberNum = i; offset = -i; }
+    } else {
+        MethodDecl *m = &classesST[cls].methodList[method];
+        int i = indexLookup(&m->localIndex, idNode->idNum);
+        int fieldClass;
+        VarDecl *field;
+        if (m->paramNameNum == idNode->idNum) { kind = VAR_PARAM; offset = FRAME_PARAM; }
+        else if (i >= 0) { kind = VAR_LOCAL; memberNum = i; offset = FRAME_LOCALS - i; }
+        else if ((field = findField(cls, idNode->idNum, &fieldClass)) != NULL) {
+            kind = VAR_FIELD;
+            classNum = fieldClass;
+            memberNum = field - classesST[fieldClass].varList;
+            offset = classesST[fieldClass].fieldOffsets[memberNum];
+        }
+    }
+    recordVar(t, kind, offset, classNum, memberNum);
+    recordVar(idNode, kind, offset, classNum, memberNum);
+}
+
+/* Resolve the variable names in the expression t, which appears in
+   method method of class cls (or the main block, if cls < 0) */
+static void resolveExpr(ASTree *t, int cls, int method) {
+    if (t == NULL) return;
+    if ((t->typ == ID_EXPR || t->typ == ASSIGN_EXPR) && t->children && t->children->data
+        && t->children->data->typ == AST_ID)
+        resolveVar(t, t->children->data, cls, method);
+    for (ASTList *cell = t->children; cell != NULL; cell = cell->next)
+        resolveExpr(cell->data, cls, method);
+}
+
+void resolveNames() {
+    resolveExpr(mainExprs, -1, -1);
+    for (int i = 1; i < numClasses; i++)
+        for (int j = 0; j < classesST[i].numMethods; j++)
+            resolveExpr(classesST[i].methodList[j].bodyExprs, i, j);
+}
+
+/* Fill decls from the count VAR_DECL children of declList */
+static void fillVarDecls(ASTree *declList, VarDecl *decls, int count) {
+    ASTList *cell = declList ? declList->children : NULL;
+    for (int i = 0; i < count; i++, cell = cell->next) {
+        ASTree *vdecl = cell->data;
+        ASTree *idNode = vdecl && vdecl->children ? vdecl->children->data : NULL;
+        ASTree *typeNode = vdecl && vdecl->children && vdecl->children->next ? vdecl->children->next->data : NULL;
+
+        decls[i].varName = idNode ? idNode->idVal : NULL;
+        decls[i].varNameNum = idNode ? idNode->idNum : -1;
+        decls[i].varNameLineNumber = idNode ? (int)idNode->lineNumber : -1;
+        decls[i].type = typeNode && typeNode->idVal ? classNumberOf(typeNode->idNum) : -3;
+        decls[i].typeLineNumber = typeNode ? (int)typeNode->lineNumber : -1;
+    }
+}
+
+void setupSymbolTables(ASTree *fullProgramAST) {
+    if (!fullProgramAST || countChildren(fullProgramAST) < 3) {
+        fprintf(stderr, "Malformed AST: not enough children.\n");
+        compileFailed(1);
+    }
+    
+    wholeProgram = fullProgramAST;
+    objectNameNum = internName("Object", 6);
+    ASTree *classList = fullProgramAST->children->data; // First child
+    ASTree *mainVarDecls = fullProgramAST->children->next->data; // Second child
+    mainExprs = fullProgramAST->children->next->next->data; // Third child
+    
+    // Safely determine number of classes (plus one for Object)
+    int userClassCount = classList && classList->children && classList->children->data ? countChildren(classList) : 0;
+    numClasses = userClassCount + 1;
+    classesST = arenaAlloc(&symtblArena, sizeof(ClassDecl) * numClasses);
+    memset(classesST, 0, sizeof(ClassDecl) * numClasses);
+
+    // Add Object class
+    classesST[0].className = "Object";
+    classesST[0].classNameNum = objectNameNum;
+    classesST[0].classNameLineNumber = 0;
+    classesST[0].superclass = -3;
+    classesST[0].superclassLineNumber = 0;
+    classesST[0].isFinal = 0;
+    classesST[0].numVars = 0;
+    classesST[0].varList = NULL;
+    classesST[0].numMethods = 0;
+    classesST[0].methodList = NULL;
+
+    // Name every class first, so types may refer to classes declared later
+    indexInit(&classIndex, numClasses);
+    ASTList *classCell = userClassCount > 0 ? classList->children : NULL;
+    for (int i = 1; i < numClasses; i++, classCell = classCell->next) {
+        ASTree *idNode = classCell->data->children->data;
+        classesST[i].className = idNode ? idNode->idVal : NULL;
+        classesST[i].classNameNum = idNode ? idNode->idNum : -1;
+        classesST[i].classNameLineNumber = idNode ? (int)idNode->lineNumber : -1;
+        indexAdd(&classIndex, classesST[i].classNameNum, i);
+    }
+
+    // Set up main block locals
+    numMainBlockLocals = countChildren(mainVarDecls);
+    mainBlockST = arenaAlloc(&symtblArena, sizeof(VarDecl) * numMainBlockLocals);
+    memset(mainBlockST, 0, sizeof(VarDecl) * numMainBlockLocals);
+    fillVarDecls(mainVarDecls, mainBlockST, numMainBlockLocals);
+    indexVars(&mainBlockIndex, mainBlockST, numMainBlockLocals);
+
+    // Add user-defined classes if any
+    classCell = userClassCount > 0 ? classList->children : NULL;
+    for (int i = 1; i < numClasses; i++, classCell = classCell->next) {
+        ASTree *classAST = classCell->data;
+        ClassDecl *classDecl = &classesST[i];
+        
+        ASTree *superclassNode = classAST->children->next->data;
+        
+        ASTree *fieldList = classAST->children->next->next->data;
+        
+        classDecl->superclass = (superclassNode && superclassNode->idVal) ? classNumberOf(superclassNode->idNum) : -3;
+        classDecl->superclassLineNumber = superclassNode ? (int)superclassNode->lineNumber : -1;
+        classDecl->isFinal = (classAST->typ == FINAL_CLASS_DECL);
+
+        // Variable fields
+        ASTree *varsNode = fieldList->children->data;
+        classDecl->numVars = varsNode ? countChildren(varsNode) : 0;
+        classDecl->varList = arenaAlloc(&symtblArena, sizeof(VarDecl) * classDecl->numVars);
+        memset(classDecl->varList, 0, sizeof(VarDecl) * classDecl->numVars);
+        fillVarDecls(varsNode, classDecl->varList, classDecl->numVars);
+        indexVars(&classDecl->varIndex, classDecl->varList, classDecl->numVars);
+
+        // Methods
+        ASTList *methodListNode = fieldList->children ? fieldList->children->next : NULL;
+        ASTree *methodsNode = methodListNode ? methodListNode->data : NULL;
+
+        classDecl->numMethods = methodsNode ? countChildren(methodsNode) : 0;
+        classDecl->methodList = arenaAlloc(&symtblArena, sizeof(MethodDecl) * classDecl->numMethods);
+        indexInit(&classDecl->methodIndex, classDecl->numMethods);
+        
+        if (classDecl->numMethods > 0) {
+            memset(classDecl->methodList, 0, sizeof(MethodDecl) * classDecl->numMethods);
+
+            ASTList *methodCell = methodsNode->children;
+            for (int j = 0; j < classDecl->numMethods; j++, methodCell = methodCell->next) {
+                ASTree *methodDeclNode = methodCell->data;
+                MethodDecl *method = &classDecl->methodList[j];
+
+                method->methodName = methodDeclNode && methodDeclNode->children ? methodDeclNode->children->data->idVal : NULL;
+                method->methodNameNum = methodDeclNode && methodDeclNode->children ? methodDeclNode->children->data->idNum : -1;
+                method->methodNameLineNumber = methodDeclNode && methodDeclNode->children ? (int)methodDeclNode->children->data->lineNumber : -1;
+                indexAdd(&classDecl->methodIndex, method->methodNameNum, j);
+
+                ASTree *retTypeNode = methodDeclNode && methodDeclNode->children->next ? methodDeclNode->children->next->data : NULL;
+                method->returnType = retTypeNode && retTypeNode->idVal ? classNumberOf(retTypeNode->idNum) : -3;
+                method->returnTypeLineNumber = retTypeNode ? (int)retTypeNode->lineNumber : -1;
+
+                ASTree *paramDeclNode = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
+                                        methodDeclNode->children->next->next->data : NULL;
+                ASTree *paramIdNode = paramDeclNode && paramDeclNode->children ? paramDeclNode->children->data : NULL;
+                ASTree *paramTypeNode = paramDeclNode && paramDeclNode->children && paramDeclNode->children->next ?
+                                        paramDeclNode->children->next->data : NULL;
+
+                method->paramName = paramIdNode ? paramIdNode->idVal : NULL;
+                method->paramNameNum = paramIdNode ? paramIdNode->idNum : -1;
+                method->paramNameLineNumber = paramIdNode ? (int)paramIdNode->lineNumber : -1;
+                method->paramType = paramTypeNode && paramTypeNode->idVal ? classNumberOf(paramTypeNode->idNum) : -3;
+                method->paramTypeLineNumber = paramTypeNode ? (int)paramTypeNode->lineNumber : -1;
+                method->isFinal = (methodDeclNode->typ == FINAL_METHOD_DECL);
+
+                ASTree *localsNode = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
+                                     methodDeclNode->children->next->next->next->data : NULL;
+                method->numLocals = localsNode ? countChildren(localsNode) : 0;
+                method->localST = arenaAlloc(&symtblArena, sizeof(VarDecl) * method->numLocals);
+                memset(method->localST, 0, sizeof(VarDecl) * method->numLocals);
+                fillVarDecls(localsNode, method->localST, method->numLocals);
+                indexVars(&method->localIndex, method->localST, method->numLocals);
+
+                ASTList *localsCell = methodDeclNode && methodDeclNode->children->next && methodDeclNode->children->next->next ?
+                                      methodDeclNode->children->next->next->next : NULL;
+                method->bodyExprs = localsCell && localsCell->next ? localsCell->next->data : NULL;
+            }
+        }
+    }
+    layoutClasses();
+    numberHierarchy();
+    resolveNames();
+}
+
+void saveSymbolTables(SymbolTables *tables) {
+    tables->wholeProgram = wholeProgram;
+    tables->mainExprs = mainExprs;
+    tables->numMainBlockLocals = numMainBlockLocals;
+    tables->mainBlockST = mainBlockST;
+    tables->mainBlockIndex = mainBlockIndex;
+    tables->numClasses = numClasses;
+    tables->classesST = classesST;
+    tables->objectNameNum = objectNameNum;
+    tables->classIndex = classIndex;
+    tables->ancestorLevels = ancestorLevels;
+}
+
+void useSymbolTables(const SymbolTables *tables) {
+    wholeProgram = tables->wholeProgram;
+    mainExprs = tables->mainExprs;
+    numMainBlockLocals = tables->numMainBlockLocals;
+    mainBlockST = tables->mainBlockST;
+    mainBlockIndex = tables->mainBlockIndex;
+    numClasses = tables->numClasses;
+    classesST = tables->classesST;
+    objectNameNum = tables->objectNameNum;
+    classIndex = tables->classIndex;
+    ancestorLevels = tables->ancestorLevels;
+}
+
+void releaseSymbolTables() {
+    arenaRelease(&symtblArena);
+    wholeProgram = NULL;
+    mainExprs = NULL;
+    numMainBlockLocals = 0;
+    mainBlockST = NULL;
+    mainBlockIndex.slots = NULL;
+    classIndex.slots = NULL;
+    ancestorLevels = 0;
+    numClasses = 0;
+    classesST = NULL;
+}
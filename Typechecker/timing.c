@@ -0,0 +1,214 @@
+/* File timing.c
+   Implementation of the per-phase timing report and trace
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "timing.h"
+#include "arena.h"
+
+_Thread_local unsigned long timedNodes = 0;
+_Thread_local unsigned long timedInstructions = 0;
+
+/* What a phase or span has cost so far, or the counters when it began */
+typedef struct {
+  double seconds;
+  unsigned long allocs;
+  size_t bytes;
+  unsigned long nodes;
+  unsigned long instructions;
+} Costs;
+
+/* The totals for one phase; phases form a tree through parent */
+typedef struct {
+  const char *name;
+  int parent;  /* index in phases, or -1 */
+  int count;
+  Costs total;
+} PhaseTotal;
+
+/* A phase or span that has begun and not yet ended */
+typedef struct {
+  const char *owner;
+  const char *name;
+  int phase;  /* index in phases, or -1 for a span */
+  Costs start;
+} OpenEntry;
+
+/* A finished phase or span, for the trace */
+typedef struct {
+  const char *owner;
+  const char *name;
+  int isPhase;
+  double start;  /* seconds since the report started */
+  Costs costs;
+} TraceEvent;
+
+static _Thread_local int recording = 0;
+static _Thread_local int tracing = 0;
+static _Thread_local double origin;
+static _Thread_local PhaseTotal *phases = NULL;
+static _Thread_local int numPhases = 0, phasesCapacity = 0;
+static _Thread_local OpenEntry *openEntries = NULL;
+static _Thread_local int numOpen = 0, openCapacity = 0;
+static _Thread_local TraceEvent *events = NULL;
+static _Thread_local int numEvents = 0, eventsCapacity = 0;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Make room in *array (of elements of size bytes) for one more */
+static void *grow(void *array, int count, int *capacity, size_t size) {
+  if (count < *capacity) return array;
+  *capacity = *capacity ? 2 * *capacity : 64;
+  array = realloc(array, size * *capacity);
+  if (array == NULL) {
+    printf("ERROR: realloc failed in the timing report\n");
+    exit(-1);
+  }
+  return array;
+}
+
+static Costs currentCosts(void) {
+  Costs c;
+  c.seconds = now();
+  c.allocs = astArena.numAllocs + symtblArena.numAllocs;
+  c.bytes = astArena.bytesAllocated + symtblArena.bytesAllocated;
+  c.nodes = timedNodes;
+  c.instructions = timedInstructions;
+  return c;
+}
+
+void startTimeReport(int withTrace) {
+  recording = 1;
+  tracing = withTrace;
+  numPhases = numOpen = numEvents = 0;
+  origin = now();
+}
+
+void stopTimeReport(void) {
+  while (numOpen > 0) {
+    if (openEntries[numOpen - 1].phase >= 0) endPhase();
+    else endSpan();
+  }
+  recording = 0;
+}
+
+static void begin(const char *owner, const char *name, int phase) {
+  openEntries = grow(openEntries, numOpen, &openCapacity, sizeof(OpenEntry));
+  OpenEntry *e = &openEntries[numOpen++];
+  e->owner = owner;
+  e->name = name;
+  e->phase = phase;
+  e->start = currentCosts();
+}
+
+/* End the innermost open entry, returning what it cost */
+static Costs end(void) {
+  OpenEntry *e = &openEntries[--numOpen];
+  Costs c = currentCosts();
+  c.seconds -= e->start.seconds;
+  c.allocs -= e->start.allocs;
+  c.bytes -= e->start.bytes;
+  c.nodes -= e->start.nodes;
+  c.instructions -= e->start.instructions;
+  if (tracing) {
+    events = grow(events, numEvents, &eventsCapacity, sizeof(TraceEvent));
+    TraceEvent *t = &events[numEvents++];
+    t->owner = e->owner;
+    t->name = e->name;
+    t->isPhase = e->phase >= 0;
+    t->start = e->start.seconds - origin;
+    t->costs = c;
+  }
+  return c;
+}
+
+void beginPhase(const char *name) {
+  if (!recording) return;
+  // the phase's parent is the innermost open phase
+  int parent = -1;
+  for (int i = numOpen - 1; i >= 0 && parent < 0; i--) parent = openEntries[i].phase;
+  int p;
+  for (p = 0; p < numPhases; p++)
+    if (phases[p].parent == parent && strcmp(phases[p].name, name) == 0) break;
+  if (p == numPhases) {
+    phases = grow(phases, numPhases, &phasesCapacity, sizeof(PhaseTotal));
+    memset(&phases[p], 0, sizeof(PhaseTotal));
+    phases[p].name = name;
+    phases[p].parent = parent;
+    numPhases++;
+  }
+  begin(NULL, name, p);
+}
+
+void endPhase(void) {
+  if (!recording || numOpen == 0) return;
+  int p = openEntries[numOpen - 1].phase;
+  Costs c = end();
+  if (p < 0) return;
+  phases[p].count++;
+  phases[p].total.seconds += c.seconds;
+  phases[p].total.allocs += c.allocs;
+  phases[p].total.bytes += c.bytes;
+  phases[p].total.nodes += c.nodes;
+  phases[p].total.instructions += c.instructions;
+}
+
+void beginSpan(const char *owner, const char *name) {
+  if (recording && tracing) begin(owner, name, -1);
+}
+
+void endSpan(void) {
+  if (recording && tracing && numOpen > 0) end();
+}
+
+/* Print phase p and the phases under it, indented by depth */
+static void printPhase(FILE *out, int p, int depth) {
+  Costs *c = &phases[p].total;
+  fprintf(out, "  %*s%-*s %5d %10.6f %9lu %11zu %9lu %9lu\n", 2 * depth, "",
+          28 - 2 * depth, phases[p].name, phases[p].count, c->seconds,
+          c->allocs, c->bytes, c->nodes, c->instructions);
+  for (int q = p + 1; q < numPhases; q++)
+    if (phases[q].parent == p) printPhase(out, q, depth + 1);
+}
+
+void printTimeReport(FILE *out) {
+  fprintf(out, "Time report:\n");
+  fprintf(out, "  %-28s %5s %10s %9s %11s %9s %9s\n", "phase", "count",
+          "seconds", "allocs", "bytes", "nodes", "instrs");
+  for (int p = 0; p < numPhases; p++)
+    if (phases[p].parent < 0) printPhase(out, p, 0);
+}
+
+int writeTrace(char *filename) {
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) {
+    printf("ERROR: could not open file %s\n", filename);
+    return 1;
+  }
+  fprintf(f, "{\"traceEvents\":[\n");
+  for (int i = 0; i < numEvents; i++) {
+    TraceEvent *t = &events[i];
+    fprintf(f, "{\"name\":\"%s%s%s\",\"cat\":\"%s\",\"ph\":\"X\",",
+            t->owner ? t->owner : "", t->owner ? "." : "", t->name,
+            t->isPhase ? "phase" : "span");
+    fprintf(f, "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,",
+            t->start * 1e6, t->costs.seconds * 1e6);
+    fprintf(f, "\"args\":{\"allocs\":%lu,\"bytes\":%zu,\"nodes\":%lu,"
+            "\"instructions\":%lu}}%s\n", t->costs.allocs, t->costs.bytes,
+            t->costs.nodes, t->costs.instructions,
+            i + 1 < numEvents ? "," : "");
+  }
+  fprintf(f, "]}\n");
+  if (fclose(f) != 0) {
+    printf("ERROR: could not write file %s\n", filename);
+    return 1;
+  }
+  return 0;
+}
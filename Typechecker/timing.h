@@ -0,0 +1,55 @@
+/* File timing.h: Per-phase timing report and trace for DJ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdio.h>
+
+/* The compiler marks out its phases with beginPhase() and endPhase()
+   (nested phases give a tree: parse, setupSymbolTables, typecheck and
+   its checks, generateDISM and its parts), and the work inside some of
+   them with beginSpan() and endSpan() (one span per class and per
+   method).  While a report is being recorded, each phase's wall time,
+   arena allocations (astArena and symtblArena, see arena.h), AST nodes
+   visited and DISM instructions emitted are added up, and if a trace
+   was asked for, every phase and span is kept as a Chrome trace event.
+   When no report is being recorded these calls cost a test each.
+   Recording is per thread; work done on other threads (such as the
+   helpers of typecheckProgramParallel()) shows up only as the time the
+   recording thread spends waiting for it. */
+
+/* Counters the phases bump as they go: AST nodes created by the parser
+   or visited by the typechecker and code generator, and DISM
+   instructions written */
+extern _Thread_local unsigned long timedNodes;
+extern _Thread_local unsigned long timedInstructions;
+
+/* Start recording a report on this thread, forgetting any earlier one;
+   if withTrace is nonzero, keep trace events too */
+void startTimeReport(int withTrace);
+
+/* Stop recording, first ending any phases and spans still open (as an
+   error leaves them) */
+void stopTimeReport(void);
+
+/* Begin and end the phase called name (a string that outlives the
+   report).  Phases nest; a phase begun more than once under the same
+   parent is reported once, with its totals and count. */
+void beginPhase(const char *name);
+void endPhase(void);
+
+/* Begin and end a span for the trace only, called owner.name (or just
+   name, if owner is NULL); both strings must last until the trace is
+   written */
+void beginSpan(const char *owner, const char *name);
+void endSpan(void);
+
+/* Print the recorded report, one line per phase, to out */
+void printTimeReport(FILE *out);
+
+/* Write the recorded trace events to file filename as Chrome
+   trace-event JSON (for chrome://tracing or Perfetto).
+   Returns 0 on success; otherwise prints an error and returns nonzero. */
+int writeTrace(char *filename);
+
+#endif
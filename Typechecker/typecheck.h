@@ -1,32 +1,46 @@
-/* File typecheck.h: Typechecker for DJ */
-
-#ifndef TYPECHECK_H
-#define TYPECHECK_H 
-
-#include "symtbl.h"
-
-/* This method performs all typechecking for the entire DJ program. 
-   This method assumes setupSymbolTables(), declared in symtbl.h,
-   has already executed to set all the global variables (i.e., the 
-   enhanced symbol tables) declared in symtbl.h.
-   If this method finds a typing error, it reports the error and 
-   exits the compiler.
-*/
-void typecheckProgram();
-
-/* HELPER METHODS FOR typecheckProgram(): */
-
-/* Returns nonzero iff sub is a subtype of super */
-int isSubtype(int sub, int super);
-
-/* Returns the type of the expression AST in the given context.
-   Also sets t->staticClassNum and t->staticMemberNum attributes as needed.
-   If classContainingExpr < 0 then this expression is in the main block of
-   the program; otherwise the expression is in the given class. 
-*/
-int typeExpr(ASTree *t, int classContainingExpr, int methodContainingExpr);
-
-/* Returns the type of the EXPR_LIST AST in the given context. */
-int typeExprs(ASTree *t, int classContainingExprs, int methodContainingExprs);
-
-#endif
+/* File typecheck.h: Typechecker for DJ */
+
+#ifndef TYPECHECK_H
+#define TYPECHECK_H 
+
+#include "symtbl.h"
+
+/* This method performs all typechecking for the entire DJ program. 
+   This method assumes setupSymbolTables(), declared in symtbl.h,
+   has already executed to set all the global variables (i.e., the 
+   enhanced symbol tables) declared in symtbl.h.
+   If this method finds a typing error, it reports the error and 
+   exits the compiler.
+*/
+void typecheckProgram();
+
+/* Same as typecheckProgram(), but the method bodies and the main block
+   are first typechecked on numThreads threads at once (each body needs
+   only the finished symbol tables).  Their results are then used in
+   typecheckProgram()'s own order, so the error reported, if any, is the
+   one typecheckProgram() would report. */
+void typecheckProgramParallel(int numThreads);
+
+/* Print the AST as printAST() does, adding to each expression the
+   annotations typecheckProgram() left on it: its static type and the
+   method, field or variable it names.  (For debugging; call after
+   typecheckProgram().) */
+void printAnnotatedAST(ASTree *t);
+
+/* HELPER METHODS FOR typecheckProgram(): */
+
+/* Returns nonzero iff sub is a subtype of super */
+int isSubtype(int sub, int super);
+
+/* Returns the type of the expression AST in the given context.
+   Also records it in t->staticType, and sets the t->staticClassNum and
+   t->staticMemberNum attributes as needed.
+   If classContainingExpr < 0 then this expression is in the main block of
+   the program; otherwise the expression is in the given class. 
+*/
+int typeExpr(ASTree *t, int classContainingExpr, int methodContainingExpr);
+
+/* Returns the type of the EXPR_LIST AST in the given context. */
+int typeExprs(ASTree *t, int classContainingExprs, int methodContainingExprs);
+
+#endif